@@ -9,6 +9,8 @@
 #include "src/memory.h"
 #include "src/string.h"
 #include "src/hash.h"
+#include "src/queue.h"
+#include "src/tree.h"
 #include "src/utils.h"
 #include "src/platform.h"
 #include "src/init.h"
@@ -0,0 +1,837 @@
+#include <queue>
+#include <vector>
+#include <thread>
+#include <mutex>
+
+
+//
+//  Benchmarks against std:: equivalents, build with optimizations on and run with --bench
+
+
+static volatile u64 g_bench_sink;
+
+f64 BenchMsSince(u64 start_mys) {
+    return (f64) (ReadSystemTimerMySec() - start_mys) / 1000.0;
+}
+
+void BenchPrint(const char *tag, u64 ops, f64 ms) {
+    printf("  %-40s %8.2f ms  %8.2f Mops/s\n", tag, ms, (f64) ops / ms / 1000.0);
+}
+
+
+void BenchHeap() {
+    printf("\nBenchHeap\n");
+
+    MArena _a = ArenaCreate();
+    MArena *a = &_a;
+    RandInit(42);
+
+    u32 cnt = 1000000;
+    u32 *vals = (u32*) ArenaAlloc(a, sizeof(u32) * cnt);
+    for (u32 i = 0; i < cnt; ++i) {
+        vals[i] = (u32) Kiss_Random(g_kiss_randstate);
+    }
+
+    u64 sum;
+    u64 start;
+
+    // push all, then pop all
+    Heap<u32> heap4 = InitHeap<u32>(a, cnt);
+    start = ReadSystemTimerMySec();
+    sum = 0;
+    for (u32 i = 0; i < cnt; ++i) {
+        heap4.Push(vals[i]);
+    }
+    while (heap4.len) {
+        sum += heap4.Pop();
+    }
+    g_bench_sink = sum;
+    BenchPrint("Heap<u32, 4> push + pop", 2 * cnt, BenchMsSince(start));
+
+    Heap<u32, 2> heap2 = InitHeap<u32, 2>(a, cnt);
+    start = ReadSystemTimerMySec();
+    sum = 0;
+    for (u32 i = 0; i < cnt; ++i) {
+        heap2.Push(vals[i]);
+    }
+    while (heap2.len) {
+        sum += heap2.Pop();
+    }
+    g_bench_sink = sum;
+    BenchPrint("Heap<u32, 2> push + pop", 2 * cnt, BenchMsSince(start));
+
+    std::priority_queue<u32, std::vector<u32>, std::greater<u32>> pq;
+    start = ReadSystemTimerMySec();
+    sum = 0;
+    for (u32 i = 0; i < cnt; ++i) {
+        pq.push(vals[i]);
+    }
+    while (pq.empty() == false) {
+        sum += pq.top();
+        pq.pop();
+    }
+    g_bench_sink = sum;
+    BenchPrint("std::priority_queue push + pop", 2 * cnt, BenchMsSince(start));
+
+    // bulk build
+    start = ReadSystemTimerMySec();
+    heap4.Heapify(vals, cnt);
+    g_bench_sink = heap4.Peek();
+    BenchPrint("Heap<u32, 4> heapify", cnt, BenchMsSince(start));
+
+    start = ReadSystemTimerMySec();
+    std::priority_queue<u32, std::vector<u32>, std::greater<u32>> pq_built(std::greater<u32>(), std::vector<u32>(vals, vals + cnt));
+    g_bench_sink = pq_built.top();
+    BenchPrint("std::priority_queue from range", cnt, BenchMsSince(start));
+
+    // top-k selection, k = 100
+    u32 k = 100;
+    heap4.Clear();
+    start = ReadSystemTimerMySec();
+    for (u32 i = 0; i < cnt; ++i) {
+        if (heap4.len < k) {
+            heap4.Push(vals[i]);
+        }
+        else if (heap4.Peek() < vals[i]) {
+            heap4.Pop();
+            heap4.Push(vals[i]);
+        }
+    }
+    g_bench_sink = heap4.Peek();
+    BenchPrint("Heap<u32, 4> top-100", cnt, BenchMsSince(start));
+
+    std::priority_queue<u32, std::vector<u32>, std::greater<u32>> pq_topk;
+    start = ReadSystemTimerMySec();
+    for (u32 i = 0; i < cnt; ++i) {
+        if (pq_topk.size() < k) {
+            pq_topk.push(vals[i]);
+        }
+        else if (pq_topk.top() < vals[i]) {
+            pq_topk.pop();
+            pq_topk.push(vals[i]);
+        }
+    }
+    g_bench_sink = pq_topk.top();
+    BenchPrint("std::priority_queue top-100", cnt, BenchMsSince(start));
+
+    ArenaDestroy(a);
+}
+
+
+void BenchQueues() {
+    printf("\nBenchQueues\n");
+
+    MArena _a = ArenaCreate();
+    MArena *a = &_a;
+    u32 total = 4000000;
+    u64 start;
+    char tag[64];
+
+    // SPSC baseline, batched consumer
+    QueueSPSC<u64> *spsc = InitQueueSPSC<u64>(a, 4096);
+    start = ReadSystemTimerMySec();
+    std::thread producer([spsc, total]() {
+        for (u64 i = 0; i < total; ++i) {
+            while (spsc->Push(i) == false) { std::this_thread::yield(); }
+        }
+    });
+    u64 buff[256];
+    u64 got = 0;
+    u64 sum = 0;
+    while (got < total) {
+        u32 n = spsc->PopBatch(buff, 256);
+        for (u32 i = 0; i < n; ++i) {
+            sum += buff[i];
+        }
+        got += n;
+        if (n == 0) {
+            std::this_thread::yield();
+        }
+    }
+    producer.join();
+    g_bench_sink = sum;
+    BenchPrint("QueueSPSC 1:1", total, BenchMsSince(start));
+
+    // MPMC, blocking producers and consumers
+    u32 ratios[] = { 1, 4, 16 };
+    for (u32 r = 0; r < 3; ++r) {
+        u32 nthreads = ratios[r];
+        u32 per_thread = total / nthreads;
+
+        QueueMPMC<u64> *q = InitQueueMPMC<u64>(a, 4096, true);
+        std::thread *threads = (std::thread*) ArenaAlloc(a, sizeof(std::thread) * 2 * nthreads);
+
+        start = ReadSystemTimerMySec();
+        for (u32 t = 0; t < nthreads; ++t) {
+            new (threads + t) std::thread([q, per_thread]() {
+                for (u64 i = 0; i < per_thread; ++i) {
+                    q->Push(i);
+                }
+            });
+            new (threads + nthreads + t) std::thread([q, per_thread]() {
+                u64 s = 0;
+                for (u64 i = 0; i < per_thread; ++i) {
+                    s += q->Pop();
+                }
+                g_bench_sink = s;
+            });
+        }
+        for (u32 t = 0; t < 2 * nthreads; ++t) {
+            threads[t].join();
+            threads[t].~thread();
+        }
+        sprintf(tag, "QueueMPMC %u:%u", nthreads, nthreads);
+        BenchPrint(tag, per_thread * nthreads, BenchMsSince(start));
+    }
+
+    ArenaDestroy(a);
+}
+
+
+void BenchPacked() {
+    printf("\nBenchPacked\n");
+
+    MArena _a = ArenaCreate();
+    MArena *a = &_a;
+    RandInit(42);
+
+    u32 cnt = 10000000;
+    List<u32> ids = InitList<u32>(a, cnt);
+    u32 val = 0;
+    for (u32 i = 0; i < cnt; ++i) {
+        val += RandIntMax(16);
+        ids.Add(val);
+    }
+
+    u64 sum;
+    u64 start;
+
+    start = ReadSystemTimerMySec();
+    sum = 0;
+    for (u32 i = 0; i < cnt; ++i) {
+        sum += ids.lst[i];
+    }
+    g_bench_sink = sum;
+    BenchPrint("List<u32> scan (4.00 bytes/value)", cnt, BenchMsSince(start));
+
+    PackCodec codecs[] = { PACK_STREAMVBYTE, PACK_BITPACK };
+    const char *names[] = { "streamvbyte", "bitpack" };
+    for (u32 c = 0; c < 2; ++c) {
+        PackedU32 packed = PackU32(a, ids, codecs[c]);
+        char tag[64];
+
+        start = ReadSystemTimerMySec();
+        sum = 0;
+        u32 buf[PACKED_BLOCK_LEN];
+        for (u32 b = 0; b < packed.nblocks; ++b) {
+            u32 n = PackedDecodeBlock(&packed, b, buf);
+            for (u32 i = 0; i < n; ++i) {
+                sum += buf[i];
+            }
+        }
+        g_bench_sink = sum;
+        sprintf(tag, "%s block scan (%.2f bytes/value)", names[c], (f64) packed.SizeBytes() / cnt);
+        BenchPrint(tag, cnt, BenchMsSince(start));
+    }
+}
+
+
+void BenchHashMap() {
+    printf("\nBenchHashMap\n");
+
+    MArena _a = ArenaCreate();
+    MArena *a = &_a;
+    RandInit(42);
+
+    u32 cnt = 2000000;
+    u64 *keys = (u64*) ArenaAlloc(a, sizeof(u64) * cnt);
+    for (u32 i = 0; i < cnt; ++i) {
+        keys[i] = RandMinMax64(1, UINT64_MAX - 1);
+    }
+
+    u64 sum;
+    u64 start;
+
+    // worst single put shows the rehash pause, incremental growth keeps it near a presized map's
+    HashMap grown = InitMap(a, 8, true);
+    u64 worst = 0;
+    start = ReadSystemTimerMySec();
+    for (u32 i = 0; i < cnt; ++i) {
+        u64 t0 = ReadSystemTimerMySec();
+        MapPut(&grown, keys[i], i + 1);
+        worst = MaxU64(worst, ReadSystemTimerMySec() - t0);
+    }
+    BenchPrint("MapPut, growing from 8 slots", cnt, BenchMsSince(start));
+    printf("  %-40s %8lu mys (%u grows)\n", "worst single MapPut", worst, grown.grows);
+
+    HashMap presized = InitMap(a, (u32) (cnt / MAP_MAX_LOAD) + 1);
+    start = ReadSystemTimerMySec();
+    for (u32 i = 0; i < cnt; ++i) {
+        MapPut(&presized, keys[i], i + 1);
+    }
+    BenchPrint("MapPut, presized", cnt, BenchMsSince(start));
+
+    start = ReadSystemTimerMySec();
+    sum = 0;
+    for (u32 i = 0; i < cnt; ++i) {
+        sum += MapGet(&grown, keys[i]);
+    }
+    g_bench_sink = sum;
+    BenchPrint("MapGet, hits", cnt, BenchMsSince(start));
+}
+
+
+void BenchMapBatch() {
+    printf("\nBenchMapBatch\n");
+
+    MArena _a = ArenaCreate();
+    MArena *a = &_a;
+    RandInit(42);
+
+    // a table that fits in cache and one of 16M slots (384MB), well beyond the last-level cache
+    u32 sizes[] = { 1 << 14, 6 << 20 };
+    u32 nqueries = 4000000;
+    u32 batch = 1024;
+    u64 *queries = (u64*) ArenaAlloc(a, sizeof(u64) * nqueries);
+    u64 *vals = (u64*) ArenaAlloc(a, sizeof(u64) * nqueries);
+    char tag[64];
+    for (u32 s = 0; s < 2; ++s) {
+        u32 cnt = sizes[s];
+        u64 *keys = (u64*) ArenaAlloc(a, sizeof(u64) * cnt);
+        for (u32 i = 0; i < cnt; ++i) {
+            keys[i] = RandMinMax64(1, UINT64_MAX - 1);
+            vals[i % nqueries] = i + 1;
+        }
+        HashMap map = InitMap(a, (u32) (cnt / MAP_MAX_LOAD) + 1);
+        for (u32 i = 0; i < cnt; i += nqueries) {
+            MapPutBatch(&map, keys + i, vals, MinU32(nqueries, cnt - i));
+        }
+        for (u32 i = 0; i < nqueries; ++i) {
+            queries[i] = keys[RandIntMax(cnt) - 1];
+        }
+
+        u64 start = ReadSystemTimerMySec();
+        u64 sum = 0;
+        for (u32 i = 0; i < nqueries; ++i) {
+            sum += MapGet(&map, queries[i]);
+        }
+        g_bench_sink = sum;
+        sprintf(tag, "MapGet, %u keys", cnt);
+        BenchPrint(tag, nqueries, BenchMsSince(start));
+
+        start = ReadSystemTimerMySec();
+        sum = 0;
+        for (u32 i = 0; i < nqueries; i += batch) {
+            MapGetBatch(&map, queries + i, vals, batch);
+            for (u32 j = 0; j < batch; ++j) {
+                sum += vals[j];
+            }
+        }
+        g_bench_sink = sum;
+        sprintf(tag, "MapGetBatch, %u keys", cnt);
+        BenchPrint(tag, nqueries, BenchMsSince(start));
+    }
+
+    ArenaDestroy(a);
+}
+
+
+void BenchDenseMap() {
+    printf("\nBenchDenseMap\n");
+
+    MArena _a = ArenaCreate();
+    MArena *a = &_a;
+    RandInit(42);
+
+    // iteration over a map that had most of its keys removed, as after a burst of churn
+    u32 cnt = 2000000;
+    HashMap hmap = InitMap(a, cnt * 2);
+    DenseMap dmap = InitDenseMap(a, cnt * 2);
+    for (u32 i = 0; i < cnt; ++i) {
+        u64 key = RandMinMax64(1, UINT64_MAX - 1);
+        MapPut(&hmap, key, i + 1);
+        MapPut(&dmap, key, i + 1);
+        if (i % 8) {
+            MapRemove(&hmap, key);
+            MapRemove(&dmap, key);
+        }
+    }
+
+    u64 start = ReadSystemTimerMySec();
+    u64 sum = 0;
+    MapIter iter = {};
+    while (KeyVal *kv = MapNext(&hmap, &iter)) {
+        sum += kv->val;
+    }
+    g_bench_sink = sum;
+    BenchPrint("HashMap MapNext, 250K of 4M slots live", hmap.load, BenchMsSince(start));
+
+    start = ReadSystemTimerMySec();
+    sum = 0;
+    iter = {};
+    while (DenseEntry *e = MapNext(&dmap, &iter)) {
+        sum += e->val;
+    }
+    g_bench_sink = sum;
+    BenchPrint("DenseMap MapNext, 250K live", dmap.len, BenchMsSince(start));
+
+    start = ReadSystemTimerMySec();
+    MapClear(&hmap);
+    printf("  %-40s %8.3f ms\n", "HashMap MapClear", BenchMsSince(start));
+    start = ReadSystemTimerMySec();
+    MapClear(&dmap);
+    printf("  %-40s %8.3f ms\n", "DenseMap MapClear", BenchMsSince(start));
+
+    ArenaDestroy(a);
+}
+
+
+void BenchSwissMap() {
+    printf("\nBenchSwissMap\n");
+
+    // both tables presized to 2^k slots and filled to 85%; the largest size (57M keys) needs about 3.7GB of
+    // memory and arenas reserved beyond the default 1GB
+    u32 log2s[] = { 20, 23, 26 };
+    for (u32 t = 0; t < 3; ++t) {
+        u32 nslots = 1u << log2s[t];
+        u64 reserve = MaxU64(ARENA_RESERVE_SIZE, sizeof(KeyVal) * nslots + MEGABYTE);
+        MArena _a = ArenaCreate(reserve);
+        MArena *a = &_a;
+        MArena _a_map = ArenaCreate(reserve);
+        MArena *a_map = &_a_map;
+        MArena _a_swiss = ArenaCreate(reserve);
+        MArena *a_swiss = &_a_swiss;
+        RandInit(42);
+
+        u32 cnt = (u32) (0.85f * nslots);
+        u64 *keys = (u64*) ArenaAlloc(a, sizeof(u64) * cnt);
+        u64 *misses = (u64*) ArenaAlloc(a, sizeof(u64) * cnt);
+        for (u32 i = 0; i < cnt; ++i) {
+            keys[i] = RandMinMax64(1, UINT64_MAX - 1);
+            misses[i] = RandMinMax64(1, UINT64_MAX - 1);
+        }
+        printf("  %u keys, load 0.85\n", cnt);
+
+        u64 sum;
+        u64 start;
+        char tag[64];
+
+        HashMap map = InitMap(a_map, nslots, false, 1.0f);
+        SwissMap swiss = InitSwissMap(a_swiss, nslots, false, 0.9f);
+
+        start = ReadSystemTimerMySec();
+        for (u32 i = 0; i < cnt; ++i) {
+            MapPut(&map, keys[i], i + 1);
+        }
+        BenchPrint("MapPut, HashMap", cnt, BenchMsSince(start));
+
+        start = ReadSystemTimerMySec();
+        for (u32 i = 0; i < cnt; ++i) {
+            MapPut(&swiss, keys[i], i + 1);
+        }
+        BenchPrint("MapPut, SwissMap", cnt, BenchMsSince(start));
+
+        u64 *probes[] = { keys, misses };
+        const char *kinds[] = { "hits", "misses" };
+        for (u32 k = 0; k < 2; ++k) {
+            start = ReadSystemTimerMySec();
+            sum = 0;
+            for (u32 i = 0; i < cnt; ++i) {
+                sum += MapGet(&map, probes[k][i]);
+            }
+            g_bench_sink = sum;
+            sprintf(tag, "MapGet, HashMap, %s", kinds[k]);
+            BenchPrint(tag, cnt, BenchMsSince(start));
+
+            start = ReadSystemTimerMySec();
+            sum = 0;
+            for (u32 i = 0; i < cnt; ++i) {
+                sum += MapGet(&swiss, probes[k][i]);
+            }
+            g_bench_sink = sum;
+            sprintf(tag, "MapGet, SwissMap, %s", kinds[k]);
+            BenchPrint(tag, cnt, BenchMsSince(start));
+        }
+
+        ArenaDestroy(a_swiss);
+        ArenaDestroy(a_map);
+        ArenaDestroy(a);
+    }
+}
+
+
+void BenchStrMap() {
+    printf("\nBenchStrMap\n");
+
+    MArena _a = ArenaCreate();
+    MArena *a = &_a;
+    MArena _a_map = ArenaCreate();
+    MArena *a_map = &_a_map;
+    MArena _a_keys = ArenaCreate();
+    MArena *a_keys = &_a_keys;
+    RandInit(42);
+
+    u32 cnt = 10000000;
+    Str *keys = (Str*) ArenaAlloc(a, sizeof(Str) * cnt);
+    for (u32 i = 0; i < cnt; ++i) {
+        char buff[32];
+        u32 len = sprintf(buff, "ident_%u_%x", i, RandIntMax(1 << 20));
+        keys[i] = StrPush(a, Str { buff, len });
+    }
+
+    u64 sum;
+    u64 start;
+
+    StrMap map = InitStrMap(a_map, a_keys);
+    start = ReadSystemTimerMySec();
+    StrMapBulkLoad(&map, keys, NULL, cnt);
+    BenchPrint("StrMapBulkLoad, 10M identifiers", cnt, BenchMsSince(start));
+    printf("  %-40s %8.2f bytes/key (slots and blob)\n", "footprint", (f64) (a_map->used + a_keys->used) / cnt);
+
+    start = ReadSystemTimerMySec();
+    sum = 0;
+    for (u32 i = 0; i < cnt; ++i) {
+        sum += StrMapGet(&map, keys[i]);
+    }
+    g_bench_sink = sum;
+    BenchPrint("StrMapGet, hits", cnt, BenchMsSince(start));
+
+    ArenaClear(a_map);
+    map = InitStrMap(a_map, a_keys);
+    start = ReadSystemTimerMySec();
+    for (u32 i = 0; i < cnt; ++i) {
+        StrMapPut(&map, keys[i], i + 1);
+    }
+    BenchPrint("StrMapPut, growing", cnt, BenchMsSince(start));
+
+    ArenaDestroy(a_keys);
+    ArenaDestroy(a_map);
+    ArenaDestroy(a);
+}
+
+
+void BenchPerfectHash() {
+    printf("\nBenchPerfectHash\n");
+
+    MArena _a = ArenaCreate();
+    MArena *a = &_a;
+    RandInit(42);
+
+    u32 cnt = 10000000;
+    List<u64> keys = InitList<u64>(a, cnt);
+    for (u32 i = 0; i < cnt; ++i) {
+        keys.Add(((u64) RandIntMax(0xFFFFFFF) << 32) | i); // distinct
+    }
+    u64 start = ReadSystemTimerMySec();
+    PerfectHash ph = PerfectHashBuild(a, keys);
+    BenchPrint("PerfectHashBuild, 10M u64 keys", cnt, BenchMsSince(start));
+    printf("  %-40s %8.2f bytes/key\n", "serialized size", (f64) PerfectHashSize(&ph) / cnt);
+
+    u64 *queries = (u64*) ArenaAlloc(a, sizeof(u64) * cnt);
+    for (u32 i = 0; i < cnt; ++i) {
+        queries[i] = keys.lst[RandIntMax(cnt) - 1];
+    }
+    start = ReadSystemTimerMySec();
+    u64 sum = 0;
+    for (u32 i = 0; i < cnt; ++i) {
+        sum += PerfectHashIdx(&ph, queries[i]);
+    }
+    g_bench_sink = sum;
+    BenchPrint("PerfectHashIdx, random keys", cnt, BenchMsSince(start));
+
+    u64 size;
+    u8 *blob = PerfectHashSerialize(a, &ph, &size);
+    start = ReadSystemTimerMySec();
+    PerfectHash loaded = PerfectHashLoad(blob, size);
+    g_bench_sink = PerfectHashIdx(&loaded, queries[0]);
+    printf("  %-40s %8.3f ms (in place, no rebuild)\n", "PerfectHashLoad", BenchMsSince(start));
+
+    ArenaDestroy(a);
+}
+
+
+void BenchHash() {
+    printf("\nBenchHash\n");
+
+    MArena _a = ArenaCreate();
+    MArena *a = &_a;
+    RandInit(42);
+
+    u32 nbytes = 1 << 20;
+    u8 *data = (u8*) ArenaAlloc(a, nbytes + 64);
+    for (u32 i = 0; i < nbytes + 64; ++i) {
+        data[i] = (u8) RandIntMax(256);
+    }
+
+    // hash 256MB in spans of each size, shifting the start so that reads are unaligned
+    u32 spans[] = { 8, 16, 32, 64, 256, 4096, 1 << 20 };
+    const char *names[] = { "HashDJB2", "HashBytes", "HashBytesAES" };
+    for (u32 f = 0; f < 3; ++f) {
+        for (u32 s = 0; s < 7; ++s) {
+            u32 span = spans[s];
+            u64 total = 256ull << 20;
+            u64 cnt = total / span;
+            u64 sum = 0;
+            u64 start = ReadSystemTimerMySec();
+            for (u64 i = 0; i < cnt; ++i) {
+                u8 *p = data + ((i * span) & (nbytes - 1)) + (i & 7);
+                if (p + span > data + nbytes + 64) {
+                    p = data + (i & 7);
+                }
+                if (f == 0) {
+                    sum += HashDJB2(Str { (char*) p, span });
+                }
+                else if (f == 1) {
+                    sum += HashBytes(p, span, i);
+                }
+                else {
+                    sum += HashBytesAES(p, span, i);
+                }
+            }
+            g_bench_sink = sum;
+            f64 ms = BenchMsSince(start);
+            char tag[64];
+            sprintf(tag, "%s, %u byte spans", names[f], span);
+            printf("  %-40s %8.2f ms  %8.2f GB/s\n", tag, ms, (f64) total / ms / 1e6);
+        }
+    }
+    if (SIMD_AES == 0) {
+        printf("  (built without -maes, HashBytesAES falls back to HashBytes)\n");
+    }
+    ArenaDestroy(a);
+}
+
+
+void BenchRand() {
+    printf("\nBenchRand\n");
+
+    MArena _a = ArenaCreate();
+    MArena *a = &_a;
+    RandInit(42);
+
+    u32 cnt = 1 << 24;
+    u64 *raw = (u64*) ArenaAlloc(a, sizeof(u64) * cnt, false);
+    f32 *fs = (f32*) ArenaAlloc(a, sizeof(f32) * cnt, false);
+    u32 *us = (u32*) ArenaAlloc(a, sizeof(u32) * cnt, false);
+    u64 start;
+
+    start = ReadSystemTimerMySec();
+    for (u32 i = 0; i < cnt; ++i) {
+        raw[i] = Kiss_Random(g_kiss_randstate);
+    }
+    BenchPrint("Kiss_Random, u64", cnt, BenchMsSince(start));
+
+    RandState r = InitRandState(42);
+    start = ReadSystemTimerMySec();
+    for (u32 i = 0; i < cnt; ++i) {
+        raw[i] = RandNext(&r);
+    }
+    BenchPrint("RandNext, u64", cnt, BenchMsSince(start));
+
+    RandBatch rb = InitRandBatch(&r);
+    start = ReadSystemTimerMySec();
+    RandFillU64(&rb, raw, cnt);
+    BenchPrint("RandFillU64", cnt, BenchMsSince(start));
+
+    start = ReadSystemTimerMySec();
+    for (u32 i = 0; i < cnt; ++i) {
+        fs[i] = Rand01_f32();
+    }
+    BenchPrint("Rand01_f32", cnt, BenchMsSince(start));
+
+    start = ReadSystemTimerMySec();
+    RandFillF32(&rb, fs, cnt);
+    BenchPrint("RandFillF32", cnt, BenchMsSince(start));
+
+    start = ReadSystemTimerMySec();
+    for (u32 i = 0; i < cnt; ++i) {
+        us[i] = RandMinMaxU(0, 999);
+    }
+    BenchPrint("RandMinMaxU, [0, 999]", cnt, BenchMsSince(start));
+
+    start = ReadSystemTimerMySec();
+    RandFillRange(&rb, us, cnt, 0, 999);
+    BenchPrint("RandFillRange, [0, 999]", cnt, BenchMsSince(start));
+
+    // counter-based: one generator per element, and bulk fills
+    start = ReadSystemTimerMySec();
+    for (u32 i = 0; i < cnt; ++i) {
+        Philox p = InitPhilox(42, i);
+        fs[i] = Rand01_f32(&p);
+    }
+    BenchPrint("Philox per element, Rand01_f32", cnt, BenchMsSince(start));
+
+    Philox p = InitPhilox(42);
+    start = ReadSystemTimerMySec();
+    PhiloxFillU32(&p, us, cnt);
+    BenchPrint("PhiloxFillU32", cnt, BenchMsSince(start));
+
+    start = ReadSystemTimerMySec();
+    PhiloxFillF32(&p, fs, cnt);
+    BenchPrint("PhiloxFillF32", cnt, BenchMsSince(start));
+
+    g_bench_sink = raw[cnt - 1] + us[cnt - 1] + (u64) fs[cnt - 1];
+    if (SIMD_AVX2 == 0) {
+        printf("  (built without -mavx2, the fills run scalar code)\n");
+    }
+
+    ArenaDestroy(a);
+}
+
+
+void BenchDistributions() {
+    printf("\nBenchDistributions\n");
+
+    MArena _a = ArenaCreate();
+    MArena *a = &_a;
+    RandState r = InitRandState(42);
+
+    u32 cnt = 1 << 24;
+    f64 *xs = (f64*) ArenaAlloc(a, sizeof(f64) * cnt, false);
+    u32 *idxs = (u32*) ArenaAlloc(a, sizeof(u32) * cnt, false);
+    u64 start;
+
+    // Box-Muller baseline, two values per pair of uniforms
+    start = ReadSystemTimerMySec();
+    for (u32 i = 0; i < cnt; i += 2) {
+        f64 u1 = _RandOpen01(&r);
+        f64 u2 = Rand01(&r);
+        f64 rad = sqrt(-2 * log(u1));
+        xs[i] = rad * cos(2 * PI * u2);
+        xs[i + 1] = rad * sin(2 * PI * u2);
+    }
+    BenchPrint("Box-Muller normal", cnt, BenchMsSince(start));
+
+    start = ReadSystemTimerMySec();
+    RandFillNormal(&r, xs, cnt);
+    BenchPrint("RandFillNormal, ziggurat", cnt, BenchMsSince(start));
+
+    start = ReadSystemTimerMySec();
+    for (u32 i = 0; i < cnt; ++i) {
+        xs[i] = -log(_RandOpen01(&r));
+    }
+    BenchPrint("-log(U) exponential", cnt, BenchMsSince(start));
+
+    start = ReadSystemTimerMySec();
+    RandFillExp(&r, xs, cnt);
+    BenchPrint("RandFillExp, ziggurat", cnt, BenchMsSince(start));
+
+    u32 nweights = 1 << 16;
+    f64 *weights = (f64*) ArenaAlloc(a, sizeof(f64) * nweights);
+    for (u32 i = 0; i < nweights; ++i) {
+        weights[i] = Rand01(&r) * Rand01(&r);
+    }
+    start = ReadSystemTimerMySec();
+    AliasTable tbl = InitAliasTable(a, weights, nweights);
+    BenchPrint("InitAliasTable, 64K weights", nweights, BenchMsSince(start));
+    start = ReadSystemTimerMySec();
+    AliasSampleBatch(&tbl, &r, idxs, cnt);
+    BenchPrint("AliasSampleBatch", cnt, BenchMsSince(start));
+
+    List<u32> lst = { idxs, cnt };
+    start = ReadSystemTimerMySec();
+    Shuffle(&r, lst);
+    BenchPrint("Shuffle, 16M u32", cnt, BenchMsSince(start));
+
+    Reservoir<u32> res = InitReservoir<u32>(a, 1000);
+    start = ReadSystemTimerMySec();
+    ReservoirAddBatch(&res, &r, idxs, cnt);
+    BenchPrint("ReservoirAddBatch, k = 1000 of 16M", cnt, BenchMsSince(start));
+    g_bench_sink = (u64) xs[cnt - 1] + res.lst[0];
+
+    ArenaDestroy(a);
+}
+
+
+void BenchConcurrentMap() {
+    printf("\nBenchConcurrentMap\n");
+
+    MArena _a = ArenaCreate();
+    MArena *a = &_a;
+    RandInit(42);
+
+    u32 nkeys = 1 << 16;
+    u32 ops_per_thread = 1000000;
+    u64 *keys = (u64*) ArenaAlloc(a, sizeof(u64) * nkeys);
+    for (u32 i = 0; i < nkeys; ++i) {
+        keys[i] = RandMinMax64(1, UINT64_MAX - 1);
+    }
+
+    // read-heavy is 95% gets, write-heavy is half puts and half removes, both over a preloaded key set
+    u32 nthreads_lst[] = { 1, 2, 4, 8 };
+    u32 write_pcts[] = { 5, 100 };
+    const char *mix_names[] = { "read-heavy", "write-heavy" };
+    char tag[64];
+    for (u32 m = 0; m < 2; ++m) {
+        u32 write_pct = write_pcts[m];
+        for (u32 n = 0; n < 4; ++n) {
+            u32 nthreads = nthreads_lst[n];
+            std::thread *threads = (std::thread*) ArenaAlloc(a, sizeof(std::thread) * nthreads);
+
+            for (u32 impl = 0; impl < 2; ++impl) {
+                ConcurrentMap cmap = InitConcurrentMap(a);
+                HashMap lmap = InitMap(a, nkeys * 2);
+                std::mutex lock;
+                for (u32 i = 0; i < nkeys; ++i) {
+                    MapPut(&cmap, keys[i], i + 1);
+                    MapPut(&lmap, keys[i], i + 1);
+                }
+
+                u64 start = ReadSystemTimerMySec();
+                for (u32 t = 0; t < nthreads; ++t) {
+                    new (threads + t) std::thread([&, t]() {
+                        u64 x = t + 1;
+                        u64 s = 0;
+                        for (u32 i = 0; i < ops_per_thread; ++i) {
+                            x = x * 6364136223846793005ull + 1442695040888963407ull;
+                            u64 key = keys[(x >> 33) & (nkeys - 1)];
+                            u32 op = (u32) (x >> 20) % 100;
+                            bool write = op < write_pct;
+                            if (impl == 0) {
+                                if (write == false) { s += MapGet(&cmap, key); }
+                                else if (op & 1) { MapPut(&cmap, key, i + 1); }
+                                else { MapRemove(&cmap, key); }
+                            }
+                            else {
+                                std::lock_guard<std::mutex> guard(lock);
+                                if (write == false) { s += MapGet(&lmap, key); }
+                                else if (op & 1) { MapPut(&lmap, key, i + 1); }
+                                else { MapRemove(&lmap, key); }
+                            }
+                        }
+                        g_bench_sink = s;
+                    });
+                }
+                for (u32 t = 0; t < nthreads; ++t) {
+                    threads[t].join();
+                    threads[t].~thread();
+                }
+                sprintf(tag, "%s, %s, %u threads", impl == 0 ? "ConcurrentMap" : "HashMap+mutex", mix_names[m], nthreads);
+                BenchPrint(tag, (u64) ops_per_thread * nthreads, BenchMsSince(start));
+                ConcurrentMapFree(&cmap);
+            }
+        }
+    }
+    printf("  (%u hardware threads)\n", std::thread::hardware_concurrency());
+
+    ArenaDestroy(a);
+}
+
+
+void Bench() {
+    printf("Running baselayer benchmarks ...\n");
+
+    BenchHeap();
+    BenchQueues();
+    BenchPacked();
+    BenchHashMap();
+    BenchMapBatch();
+    BenchDenseMap();
+    BenchSwissMap();
+    BenchStrMap();
+    BenchPerfectHash();
+    BenchHash();
+    BenchRand();
+    BenchDistributions();
+    BenchConcurrentMap();
+}
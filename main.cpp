@@ -1,5 +1,6 @@
 #include "baselayer_includes.h"
 #include "test.cpp"
+#include "bench.cpp"
 
 
 int main (int argc, char **argv) {
@@ -12,6 +13,7 @@ int main (int argc, char **argv) {
         printf("--version:      Print baselayer version\n");
         printf("--release:      Combine source files into jg_baselayer.h\n");
         printf("--test:         Run test functions\n");
+        printf("--bench:        Run benchmarks\n");
         exit(0);
     }
 
@@ -19,6 +21,10 @@ int main (int argc, char **argv) {
         Test();
     }
 
+    else if (CLAContainsArg("--bench", argc, argv)) {
+        Bench();
+    }
+
     else if (CLAContainsArg("--version", argc, argv) || force_tests) {
         printf("dev: ");
         BaselayerPrintVersion();
@@ -36,6 +42,8 @@ int main (int argc, char **argv) {
         f_sources = StrLstPush("src/memory.h", f_sources);
         f_sources = StrLstPush("src/string.h", f_sources);
         f_sources = StrLstPush("src/hash.h", f_sources);
+        f_sources = StrLstPush("src/queue.h", f_sources);
+        f_sources = StrLstPush("src/tree.h", f_sources);
         f_sources = StrLstPush("src/utils.h", f_sources);
         f_sources = StrLstPush("src/platform.h", f_sources);
         f_sources = StrLstPush("src/init.h", f_sources);
@@ -15,6 +15,39 @@
 #include <cstring>
 
 
+//
+// SIMD availability
+
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define SIMD_SSE2 1
+    #include <emmintrin.h>
+#else
+    #define SIMD_SSE2 0
+#endif
+
+#if defined(__SSSE3__) || defined(__AVX__)
+    #define SIMD_SSSE3 1
+    #include <tmmintrin.h>
+#else
+    #define SIMD_SSSE3 0
+#endif
+
+#if defined(__AVX2__)
+    #define SIMD_AVX2 1
+    #include <immintrin.h>
+#else
+    #define SIMD_AVX2 0
+#endif
+
+#if defined(__AES__)
+    #define SIMD_AES 1
+    #include <wmmintrin.h>
+#else
+    #define SIMD_AES 0
+#endif
+
+
 //
 // basics
 
@@ -48,6 +81,8 @@ typedef double f64;
 #define GIGABYTE (1024 * 1024 * 1024)
 #define FOUR_GB (4 * 1024 * 1024 * 1024)
 
+#define CACHE_LINE_SIZE 64
+
 
 #define PI 3.14159f
 f32 deg2rad = PI / 180.0f;
@@ -86,6 +121,36 @@ inline void _memzero(void *dest, size_t n) {
 }
 
 
+//
+// bit ops (input must be non-zero for ctz/clz)
+
+
+#ifdef _MSC_VER
+#include <intrin.h>
+inline u32 CtzU32(u32 x) { unsigned long i; _BitScanForward(&i, x); return (u32) i; }
+inline u32 ClzU32(u32 x) { unsigned long i; _BitScanReverse(&i, x); return 31 - (u32) i; }
+inline u32 PopcntU32(u32 x) { return (u32) __popcnt(x); }
+#else
+inline u32 CtzU32(u32 x) { return (u32) __builtin_ctz(x); }
+inline u32 ClzU32(u32 x) { return (u32) __builtin_clz(x); }
+inline u32 PopcntU32(u32 x) { return (u32) __builtin_popcount(x); }
+#endif
+
+
+//
+// prefetch (a hint, never faults)
+
+
+inline
+void Prefetch(const void *addr) {
+#if SIMD_SSE2
+    _mm_prefetch((const char*) addr, _MM_HINT_T0);
+#elif defined(__GNUC__)
+    __builtin_prefetch(addr);
+#endif
+}
+
+
 //
 // linked list
 
@@ -126,6 +191,18 @@ void InsertBefore2(void *newlink, void *before) {
     }
     befre->prev = newlnk;
 }
+void Remove2(void *link) {
+    LList2 *lnk = (LList2*) link;
+
+    if (lnk->prev != NULL) {
+        lnk->prev->next = lnk->next;
+    }
+    if (lnk->next != NULL) {
+        lnk->next->prev = lnk->prev;
+    }
+    lnk->next = NULL;
+    lnk->prev = NULL;
+}
 void InsertBelow3(void *newlink, void *below) {
     LList3 *newlnk = (LList3*) newlink;
     LList3 *belw = (LList3*) below;
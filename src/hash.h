@@ -1,6 +1,18 @@
 #ifndef __HASH_H__
 #define __HASH_H__
 
+#include <cmath>
+#include <atomic>
+#include <thread>
+
+
+//
+// platform dependent:
+
+
+void FutexWait(std::atomic<u32> *addr, u32 expected);
+void FutexWake(std::atomic<u32> *addr, u32 cnt);
+
 
 //
 // hash map
@@ -13,9 +25,12 @@ u32 Hash32(u32 x) {
     return x;
 }
 u64 Hash64(u64 x) {
-    x = ((x >> 16) ^ x) * 0x45d9f3b;
-    x = ((x >> 16) ^ x) * 0x45d9f3b;
-    x = ((x >> 16) ^ x);
+    // splitmix64 finalizer: full avalanche, every input bit flips each output bit with probability ~1/2
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
     return x;
 }
 #ifdef __arm__
@@ -43,15 +58,146 @@ u64 HashDJB2(Str skey) {
     return hash;
 }
 
+//
+//  Byte hashing
+//
+//  HashBytes follows wyhash (final version 4, public domain, see https://github.com/wangyi-fudan/wyhash): 64x64->128 bit
+//  multiply-mix over 16 bytes per step, three independent lanes for spans above 48 bytes, overlapping reads for the
+//  tail and no byte loop. Input words are read as little-endian on every host, so its output is the same on every
+//  platform and it is the one to use for hashes that get stored. HashBytesAES runs two AES-round lanes over 32
+//  bytes per step when built with AES-NI (-maes); its values depend on the build, so keep them in memory.
+
+
+static const u64 g_wyp[4] = { 0x2d358dccaa6c78a5ull, 0x8bb84b93962eacc9ull, 0x4b33a62ed433d4a3ull, 0x4d5a2da51de1aa47ull };
+
+inline
+void _WyMum(u64 *a, u64 *b) {
+    #if defined(__SIZEOF_INT128__)
+    __uint128_t r = (__uint128_t) *a * *b;
+    *a = (u64) r;
+    *b = (u64) (r >> 64);
+    #elif defined(_MSC_VER) && defined(_M_X64)
+    *a = _umul128(*a, *b, b);
+    #else
+    u64 ha = *a >> 32, hb = *b >> 32, la = (u32) *a, lb = (u32) *b;
+    u64 rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+    u64 t = rl + (rm0 << 32);
+    u64 c = t < rl;
+    u64 lo = t + (rm1 << 32);
+    c += lo < t;
+    *a = lo;
+    *b = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+    #endif
+}
+
+inline
+u64 _WyMix(u64 a, u64 b) {
+    _WyMum(&a, &b);
+    return a ^ b;
+}
+
+// reads are little-endian on every host, so that hashes agree across byte orders
+#if defined(__BYTE_ORDER__) && defined(__ORDER_BIG_ENDIAN__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+inline u64 _WyRead8(const u8 *p) { u64 v; memcpy(&v, p, 8); return __builtin_bswap64(v); }
+inline u64 _WyRead4(const u8 *p) { u32 v; memcpy(&v, p, 4); return __builtin_bswap32(v); }
+#else
+inline u64 _WyRead8(const u8 *p) { u64 v; memcpy(&v, p, 8); return v; }
+inline u64 _WyRead4(const u8 *p) { u32 v; memcpy(&v, p, 4); return v; }
+#endif
+inline u64 _WyRead3(const u8 *p, u64 k) { return ((u64) p[0] << 16) | ((u64) p[k >> 1] << 8) | p[k - 1]; }
+
+u64 HashBytes(const void *key, u64 len, u64 seed = 0) {
+    const u8 *p = (const u8*) key;
+    seed ^= _WyMix(seed ^ g_wyp[0], g_wyp[1]);
+
+    u64 a;
+    u64 b;
+    if (len <= 16) {
+        if (len >= 4) {
+            a = (_WyRead4(p) << 32) | _WyRead4(p + ((len >> 3) << 2));
+            b = (_WyRead4(p + len - 4) << 32) | _WyRead4(p + len - 4 - ((len >> 3) << 2));
+        }
+        else if (len > 0) {
+            a = _WyRead3(p, len);
+            b = 0;
+        }
+        else {
+            a = 0;
+            b = 0;
+        }
+    }
+    else {
+        u64 i = len;
+        if (i > 48) {
+            u64 see1 = seed;
+            u64 see2 = seed;
+            do {
+                seed = _WyMix(_WyRead8(p) ^ g_wyp[1], _WyRead8(p + 8) ^ seed);
+                see1 = _WyMix(_WyRead8(p + 16) ^ g_wyp[2], _WyRead8(p + 24) ^ see1);
+                see2 = _WyMix(_WyRead8(p + 32) ^ g_wyp[3], _WyRead8(p + 40) ^ see2);
+                p += 48;
+                i -= 48;
+            } while (i > 48);
+            seed ^= see1 ^ see2;
+        }
+        while (i > 16) {
+            seed = _WyMix(_WyRead8(p) ^ g_wyp[1], _WyRead8(p + 8) ^ seed);
+            i -= 16;
+            p += 16;
+        }
+        a = _WyRead8(p + i - 16);
+        b = _WyRead8(p + i - 8);
+    }
+
+    a ^= g_wyp[1];
+    b ^= seed;
+    _WyMum(&a, &b);
+    return _WyMix(a ^ g_wyp[0] ^ len, b ^ g_wyp[1]);
+}
+
+u64 HashBytesAES(const void *key, u64 len, u64 seed = 0) {
+    #if SIMD_AES
+    if (len >= 32) {
+        const u8 *p = (const u8*) key;
+        __m128i k0 = _mm_set_epi64x((s64) g_wyp[0], (s64) (seed ^ len));
+        __m128i k1 = _mm_set_epi64x((s64) g_wyp[1], (s64) (seed ^ g_wyp[2]));
+        __m128i s0 = k1;
+        __m128i s1 = k0;
+
+        // the last step overlaps the previous one instead of padding the tail
+        u64 i = 0;
+        while (true) {
+            u64 at = MinU64(i, len - 32);
+            s0 = _mm_aesenc_si128(_mm_xor_si128(s0, _mm_loadu_si128((__m128i*) (p + at))), k0);
+            s1 = _mm_aesenc_si128(_mm_xor_si128(s1, _mm_loadu_si128((__m128i*) (p + at + 16))), k1);
+            if (at == len - 32) {
+                break;
+            }
+            i += 32;
+        }
+
+        __m128i s = _mm_aesenc_si128(s0, s1);
+        s = _mm_aesenc_si128(s, k0);
+        s = _mm_aesenc_si128(s, k1);
+        u64 lo = (u64) _mm_cvtsi128_si64(s);
+        u64 hi = (u64) _mm_cvtsi128_si64(_mm_unpackhi_epi64(s, s));
+        return _WyMix(lo ^ g_wyp[3], hi);
+    }
+    #endif
+
+    // short spans, or no AES-NI
+    return HashBytes(key, len, seed);
+}
+
 inline
 u64 HashStringValue(Str key) {
-    u64 hash = HashDJB2(key);
+    u64 hash = HashBytes(key.str, key.len);
     return hash;
 }
 
 inline
 u64 HashStringValue(const char *key) {
-    u64 hash = HashDJB2( StrL(key) );
+    u64 hash = HashBytes(key, strlen(key));
     return hash;
 }
 
@@ -67,14 +213,26 @@ struct KeyVal {
     s64 next;
 };
 
+#define MAP_REHASH_STEP 64
+#define MAP_MAX_LOAD 0.75f
+
 struct HashMap {
     Array<KeyVal> slots;
+    u32 shift;              // 64 - log2(slots.len)
     u32 collisions;
     u32 load;
     u32 overflows;
 
+    // growth: the old table is drained a few slots per operation while both tables serve lookups
+    MArena *a_grow;         // NULL for a fixed-size map
+    f32 max_load;
+    Array<KeyVal> old;
+    u32 old_shift;
+    u32 rehash_pos;
+    u32 grows;
+
     void Print() {
-        printf("load: %u, collisions: %u, overflows: %u\n", load, collisions, overflows);
+        printf("load: %u, collisions: %u, overflows: %u, slots: %u, grows: %u\n", load, collisions, overflows, slots.len, grows);
     }
     void PrintElements() {
         for (s32 i = 0; i < slots.len; ++i) {
@@ -84,10 +242,21 @@ struct HashMap {
     }
 };
 
-HashMap InitMap(MArena *a_dest, u32 nslots = 1023) {
+HashMap InitMap(MArena *a_dest, u32 nslots = 1024, bool grow = false, f32 max_load = MAP_MAX_LOAD) {
+    // nslots is rounded up to a power of two; a fixed-size map counts overflows and refuses puts once full,
+    // a growing map doubles on a_dest once load exceeds max_load * nslots
+    assert(max_load > 0 && max_load <= 1);
+
+    u32 log2 = 3;
+    while ((1u << log2) < nslots) {
+        log2++;
+    }
     HashMap map = {};
-    map.slots = InitArray<KeyVal>(a_dest, nslots);
-    map.slots.len = nslots;
+    map.slots = InitArray<KeyVal>(a_dest, 1u << log2);
+    map.slots.len = 1u << log2;
+    map.shift = 64 - log2;
+    map.a_grow = grow ? a_dest : NULL;
+    map.max_load = max_load;
     return map;
 }
 
@@ -96,130 +265,248 @@ void MapClear(HashMap *map) {
     map->collisions = 0;
     map->load = 0;
     map->overflows = 0;
+    map->old = {};
+    map->rehash_pos = 0;
 }
 
 struct MapIter {
+    // walks the live entries of a map that is not modified meanwhile; zero-initialize to start
     s32 slot_idx;
     s32 occ_slots_cnt;
 };
 
-s64 MapPut(HashMap *map, u64 key, u64 val) {
-    assert(key != 0);
+// NOTE: Collision chains are linked by relative next offsets and may coalesce. Removed slots keep their next
+//      offset (key == 0, next != 0) so chains running through them stay intact, and are re-used by puts walking
+//      that chain. New chain links only ever point to slots with next == 0, which rules out cycles.
+//      When no unlinked slot is left, MapRebuild re-links the live entries of the current table.
+//
+// NOTE: Base slots come from the high bits of a Fibonacci multiply, which spreads aligned pointers and sequential
+//      ids over a power-of-two table without a division. During a rehash a key lives in exactly one of the two
+//      tables: migrated slots are left behind as removed slots, and a put to a key still in the old table moves
+//      it over right away.
 
-    u64 len = (u64) map->slots.len;
+inline
+u64 _MapSlotIdx(u64 key, u32 shift) {
+    return (key * 0x9E3779B97F4A7C15ull) >> shift;
+}
 
-    // full-guard
-    if (map->load == len) {
-        map->overflows++;
-        return -1;
+KeyVal *_MapFind(Array<KeyVal> table, u32 shift, u64 key) {
+    KeyVal *slot = table.arr + _MapSlotIdx(key, shift);
+    while (true) {
+        if (slot->key == key) {
+            return slot;
+        }
+        if (slot->next == 0) {
+            return NULL;
+        }
+        slot = slot + slot->next;
     }
+}
 
-    KeyVal *slot0 = map->slots.arr + (key % len);
-    KeyVal *slot;
+KeyVal *_MapTablePut(HashMap *map, u64 key, u64 val, bool *added) {
+    // puts into the current table, returns NULL when only removed-but-linked slots are left
+    u64 len = (u64) map->slots.len;
+    KeyVal *slot = map->slots.arr + _MapSlotIdx(key, map->shift);
+    KeyVal *vacant = NULL;
+    *added = false;
 
-    if (slot0->next || slot0->key) {
+    if (slot->next || slot->key) {
         map->collisions++;
+    }
 
-        // find the end of the collision chain - or overwrite at matching key within the chain
-        while (slot0->next && slot0->key) {
-
-            if (slot0->key == key) {
-                // overwrite
-                slot0->val = val;
-
-                return slot - map->slots.arr;
-            }
-
-            slot0 = slot0 + slot0->next;
+    // walk the whole chain - overwrite at matching key, remember the first vacant slot
+    while (true) {
+        if (slot->key == key) {
+            slot->val = val;
+            return slot;
         }
-        slot = slot0;
+        if (slot->key == 0 && vacant == NULL) {
+            vacant = slot;
+        }
+        if (slot->next == 0) {
+            break;
+        }
+        slot = slot + slot->next;
+    }
 
-        // fint an empty slot
-        while (slot->key != 0) {
+    if (vacant == NULL) {
+        // find an unlinked empty slot and append it to the chain
+        KeyVal *tail = slot;
+        u64 probes = 0;
+        do {
             slot++;
+            probes++;
 
             // wrap-around
             if (slot == map->slots.arr + len) {
                 slot = map->slots.arr;
             }
-        }
+            if (probes == len) {
+                return NULL;
+            }
+        } while (slot->key != 0 || slot->next != 0);
 
-        // add to the collision chain
-        if (slot0 != slot) {
-            slot0->next = slot - slot0;
-        }
+        tail->next = slot - tail;
+        vacant = slot;
+    }
+
+    // sanity check pointer are in range
+    assert(vacant >= map->slots.arr);
+    assert(vacant < map->slots.arr + len);
+
+    vacant->key = key;
+    vacant->val = val;
+    *added = true;
+    return vacant;
+}
 
-        // sanity check pointer are in range
-        assert(slot >= map->slots.arr);
-        assert(slot < map->slots.arr + len);
-        assert(slot0 >= map->slots.arr);
-        assert(slot0 < map->slots.arr + len);
+void MapRebuild(HashMap *map) {
+    // re-inserts the live entries of the current table into it, dropping removed-but-linked slots
+    u32 cnt = 0;
+    for (u32 i = 0; i < map->slots.len; ++i) {
+        cnt += (map->slots.arr[i].key != 0);
     }
-    else {
-        slot = slot0;
+    KeyVal *live = (KeyVal*) malloc(sizeof(KeyVal) * MaxU32(cnt, 1));
+
+    cnt = 0;
+    for (u32 i = 0; i < map->slots.len; ++i) {
+        if (map->slots.arr[i].key) {
+            live[cnt++] = map->slots.arr[i];
+        }
     }
+    memset(map->slots.arr, 0, sizeof(KeyVal) * map->slots.len);
 
-    slot->key = key;
-    slot->val = val;
-    map->load++;
+    bool added;
+    for (u32 i = 0; i < cnt; ++i) {
+        KeyVal *kv = _MapTablePut(map, live[i].key, live[i].val, &added);
+        assert(kv != NULL);
+        (void) kv;
+    }
+    free(live);
+}
 
-    return slot - map->slots.arr;
+void _MapMigrate(HashMap *map, KeyVal *kv) {
+    bool added;
+    if (_MapTablePut(map, kv->key, kv->val, &added) == NULL) {
+        MapRebuild(map);
+        _MapTablePut(map, kv->key, kv->val, &added);
+    }
+    kv->key = 0;
+    kv->val = 0;
 }
 
-u64 MapGet(HashMap *map, u64 key) {
-    if (key == 0) {
-        return 0;
+void _MapRehashStep(HashMap *map, u32 nslots) {
+    u32 end = MinU32(map->rehash_pos + nslots, map->old.len);
+    for (; map->rehash_pos < end; ++map->rehash_pos) {
+        KeyVal *kv = map->old.arr + map->rehash_pos;
+        if (kv->key) {
+            _MapMigrate(map, kv);
+        }
     }
-    u64 len = (u64) map->slots.len;
+    if (map->rehash_pos == map->old.len) {
+        // the drained table stays on the arena
+        map->old = {};
+        map->rehash_pos = 0;
+    }
+}
 
-    // check the base slot
-    KeyVal *slot = map->slots.arr + (key % len);
+void _MapGrow(HashMap *map) {
+    if (map->old.len) {
+        _MapRehashStep(map, map->old.len);
+    }
+    map->old = map->slots;
+    map->old_shift = map->shift;
+    map->rehash_pos = 0;
+
+    map->slots = InitArray<KeyVal>(map->a_grow, 2 * map->old.len);
+    map->slots.len = 2 * map->old.len;
+    map->shift--;
+    map->grows++;
+}
 
-    if (slot->key == key) {
-        return slot->val;
+void MapRehashFinish(HashMap *map) {
+    // drains a pending rehash at once, e.g. before a read-mostly phase
+    if (map->old.len) {
+        _MapRehashStep(map, map->old.len);
     }
+}
 
-    // iterate the collision chain
-    s64 key_stop = slot->key;
-    while (slot->next) {
-        slot = slot + slot->next;
+s64 MapPut(HashMap *map, u64 key, u64 val) {
+    assert(key != 0);
 
-        if (slot->key == key) {
-            return slot->val;
+    if (map->a_grow == NULL) {
+        // full-guard
+        if (map->load == map->slots.len) {
+            map->overflows++;
+            return -1;
         }
-        else if (slot->key == key_stop) {
-            break;
+    }
+    else if (map->load + 1 > map->max_load * map->slots.len) {
+        _MapGrow(map);
+    }
+
+    if (map->old.len) {
+        _MapRehashStep(map, MAP_REHASH_STEP);
+    }
+    if (map->old.len) {
+        KeyVal *kv = _MapFind(map->old, map->old_shift, key);
+        if (kv) {
+            kv->val = val;
+            _MapMigrate(map, kv);
+            return _MapFind(map->slots, map->shift, key) - map->slots.arr;
         }
     }
 
+    bool added;
+    KeyVal *kv = _MapTablePut(map, key, val, &added);
+    if (kv == NULL) {
+        MapRebuild(map);
+        kv = _MapTablePut(map, key, val, &added);
+    }
+    map->load += added;
+
+    return kv - map->slots.arr;
+}
+
+u64 MapGet(HashMap *map, u64 key) {
+    // gets don't advance a rehash, so lookups never move entries under a MapIter; a map that turns read-mostly
+    // right after growing probes both tables on a miss until MapRehashFinish or further puts / removes
+    if (key == 0) {
+        return 0;
+    }
+
+    KeyVal *kv = _MapFind(map->slots, map->shift, key);
+    if (kv == NULL && map->old.len) {
+        kv = _MapFind(map->old, map->old_shift, key);
+    }
+    if (kv) {
+        return kv->val;
+    }
+
     // no takers
     return 0;
 }
 
 s64 MapGetIndex(HashMap *map, u64 key, s64 *prev_idx) {
+    // index in the current table, -1 also for keys still waiting in the old table during a rehash
     assert(prev_idx);
     *prev_idx = -1;
 
-    u64 len = (u64) map->slots.len;
-
-    // check the base slot
-    KeyVal *slot = map->slots.arr + (key % len);
-    if (slot->key == key) {
-        return slot - map->slots.arr;
+    if (key == 0) {
+        return -1;
     }
 
-    // iterate the collision chain
-    s64 key_stop = slot->key;
-    while (slot->next) {
-        *prev_idx = slot - map->slots.arr;
-        slot = slot + slot->next;
-
+    // iterate the collision chain from the base slot
+    KeyVal *slot = map->slots.arr + _MapSlotIdx(key, map->shift);
+    while (true) {
         if (slot->key == key) {
             return slot - map->slots.arr;
         }
-        else if (slot->key == key_stop) {
+        if (slot->next == 0) {
             break;
         }
+        *prev_idx = slot - map->slots.arr;
+        slot = slot + slot->next;
     }
 
     // no get
@@ -228,37 +515,31 @@ s64 MapGetIndex(HashMap *map, u64 key, s64 *prev_idx) {
 }
 
 s64 MapRemove(HashMap *map, u64 key) {
-    u64 len = (u64) map->slots.len;
-    s64 prev_idx;
-    s64 remove_idx = MapGetIndex(map, key, &prev_idx);
-
-    if (remove_idx == -1) {
+    // -1 if not found, otherwise the slot index in the table the key was found in, which is the old table for
+    // a key not yet migrated during a rehash
+    if (key == 0) {
         return -1;
     }
+    if (map->old.len) {
+        _MapRehashStep(map, MAP_REHASH_STEP);
+    }
 
-    KeyVal *remove = map->slots.arr + remove_idx;
-    assert(remove->key == key);
-
-    if (prev_idx >= 0) {
-        KeyVal *prev = map->slots.arr + prev_idx;
-        assert(prev->next + prev_idx == remove - map->slots.arr);
-
-        if (prev->key == 0 && prev->val == 0) {
-            assert(prev->next);
-        }
-        if (remove->next) {
-            prev->next += remove->next;
-        }
-        else {
-            prev->next = 0;
-        }
+    Array<KeyVal> table = map->slots;
+    KeyVal *remove = _MapFind(map->slots, map->shift, key);
+    if (remove == NULL && map->old.len) {
+        table = map->old;
+        remove = _MapFind(map->old, map->old_shift, key);
+    }
+    if (remove == NULL) {
+        return -1;
     }
 
+    // the slot stays linked, see the note on MapPut
     remove->key = 0;
     remove->val = 0;
     map->load--;
 
-    return remove_idx;
+    return remove - table.arr;
 }
 
 // wrappers
@@ -283,92 +564,2974 @@ s64 MapRemove(HashMap *map, Str skey) {
     return MapRemove(map, HashStringValue(skey));
 }
 
+// batches: the base slot of the key MAP_PREFETCH_DIST places ahead is prefetched before the current key is
+// resolved, so that many cache misses are in flight at once instead of being waited on one after the other.
+// The rolling prefetch stands in for hashing the whole batch up front: a slot index is a single multiply, which
+// is cheaper to redo than to store and reload from a scratch array. During a rehash the key's base slot in the
+// old table is prefetched as well, since lookups that miss the current table fall back to it.
+#define MAP_PREFETCH_DIST 16
 
-//
-// random
-
+inline
+void _MapPrefetch(HashMap *map, u64 key) {
+    Prefetch(map->slots.arr + _MapSlotIdx(key, map->shift));
+    if (map->old.len) {
+        Prefetch(map->old.arr + _MapSlotIdx(key, map->old_shift));
+    }
+}
 
-#ifndef ULONG_MAX
-#  define ULONG_MAX ( (u64) 0xffffffffffffffffUL )
-#endif
+void MapGetBatch(HashMap *map, u64 *keys, u64 *vals, u32 cnt) {
+    // vals[i] = MapGet(map, keys[i])
+    for (u32 i = 0; i < MinU32(MAP_PREFETCH_DIST, cnt); ++i) {
+        _MapPrefetch(map, keys[i]);
+    }
+    for (u32 i = 0; i < cnt; ++i) {
+        if (i + MAP_PREFETCH_DIST < cnt) {
+            _MapPrefetch(map, keys[i + MAP_PREFETCH_DIST]);
+        }
+        u64 key = keys[i];
+        KeyVal *slot = map->slots.arr + _MapSlotIdx(key, map->shift);
+        while (slot->key != key && slot->next) {
+            slot = slot + slot->next;
+        }
+        if (slot->key != key || key == 0) {
+            slot = (map->old.len && key) ? _MapFind(map->old, map->old_shift, key) : NULL;
+        }
+        vals[i] = slot ? slot->val : 0;
+    }
+}
 
-void Kiss_SRandom(u64 state[7], u64 seed) {
-    if (seed == 0) seed = 1;
-    state[0] = seed | 1; // x
-    state[1] = seed | 2; // y
-    state[2] = seed | 4; // z
-    state[3] = seed | 8; // w
-    state[4] = 0;        // carry
+u32 MapPutBatch(HashMap *map, u64 *keys, u64 *vals, u32 cnt) {
+    // MapPut for each pair in order, returns the number stored (less than cnt only for a full fixed-size map)
+    for (u32 i = 0; i < MinU32(MAP_PREFETCH_DIST, cnt); ++i) {
+        _MapPrefetch(map, keys[i]);
+    }
+    u32 stored = 0;
+    for (u32 i = 0; i < cnt; ++i) {
+        if (i + MAP_PREFETCH_DIST < cnt) {
+            _MapPrefetch(map, keys[i + MAP_PREFETCH_DIST]);
+        }
+        stored += (MapPut(map, keys[i], vals[i]) >= 0);
+    }
+    return stored;
 }
-u64 Kiss_Random(u64 state[7]) {
-    state[0] = state[0] * 69069 + 1;
-    state[1] ^= state[1] << 13;
-    state[1] ^= state[1] >> 17;
-    state[1] ^= state[1] << 5;
-    state[5] = (state[2] >> 2) + (state[3] >> 3) + (state[4] >> 2);
-    state[6] = state[3] + state[3] + state[2] + state[4];
-    state[2] = state[3];
-    state[3] = state[6];
-    state[4] = state[5] >> 30;
-    return state[0] + state[1] + state[3];
+
+KeyVal *MapNext(HashMap *map, MapIter *iter) {
+    // NULL when done; scans the old table first during a rehash and stops after the last live slot
+    u32 len = map->old.len + map->slots.len;
+    while (iter->occ_slots_cnt < (s32) map->load && (u32) iter->slot_idx < len) {
+        u32 idx = iter->slot_idx++;
+        KeyVal *kv = (idx < map->old.len) ? map->old.arr + idx : map->slots.arr + idx - map->old.len;
+        if (kv->key) {
+            iter->occ_slots_cnt++;
+            return kv;
+        }
+    }
+    return NULL;
 }
-u64 g_kiss_randstate[7];
 
-u32 RandInit(u32 seed = 0) {
-    if (seed == 0) {
-        seed = (u32) Hash(ReadSystemTimerMySec());
+
+//
+//  Insertion-ordered hash map
+//
+//  Entries are appended to a dense array in insertion order and found through a separate index table of
+//  { generation, entry } pairs with linear probing, so iterating is a walk over the entry array and the index
+//  stays 8 bytes per slot. MapClear is O(1): it bumps the generation, which empties every index slot at once.
+//  Removes shift the index run back and leave a hole (key 0) in the entry array, keeping the order of the rest;
+//  holes are compacted away once they make up a quarter of the entries or the index grows. Key 0 is reserved.
+/*
+    DenseMap map = InitDenseMap(a);
+    MapPut(&map, key, val);
+
+    MapIter iter = {};
+    while (DenseEntry *e = MapNext(&map, &iter)) {
+        ...
     }
-    Kiss_SRandom(g_kiss_randstate, seed);
-    Kiss_Random(g_kiss_randstate); // flush the first one
+*/
 
-    return seed;
-}
 
-u64 RandMinMax64(u64 min, u64 max) {
-    assert(max > min);
+struct DenseEntry {
+    u64 key;    // 0 marks a removed entry
+    u64 val;
+};
+
+struct DenseSlot {
+    u32 gen;    // a slot is occupied only if gen equals the map's
+    u32 entry;
+};
+
+struct DenseMap {
+    DenseSlot *index;
+    DenseEntry *entries;
+    u32 len;            // live entries
+    u32 used;           // entries including holes
+    u32 cap;            // entries that fit before the index grows
+    u32 gen;
+    u64 mask;
+    u32 shift;
+    f32 max_load;
+    MArena *a_grow;
+};
 
-    return Kiss_Random(g_kiss_randstate) % (max - min + 1) + min;
+inline
+u64 _DenseHome(DenseMap *map, u64 key) {
+    return (key * 0x9E3779B97F4A7C15ull) >> map->shift;
 }
 
+void _DenseAlloc(DenseMap *map, u32 nslots) {
+    map->index = (DenseSlot*) ArenaAllocAligned(map->a_grow, sizeof(DenseSlot) * nslots, CACHE_LINE_SIZE);
+    map->mask = nslots - 1;
+    map->shift = 64;
+    for (u32 n = nslots; n > 1; n >>= 1) {
+        map->shift--;
+    }
+    map->cap = (u32) (map->max_load * nslots);
+    map->entries = (DenseEntry*) ArenaAlloc(map->a_grow, sizeof(DenseEntry) * map->cap, false);
+}
 
-f64 Rand01() {
-    f64 randnum = (f64) Kiss_Random(g_kiss_randstate);
-    randnum /= (f64) ULONG_MAX + 1;
-    return randnum;
+DenseMap InitDenseMap(MArena *a_dest, u32 nslots = 16, f32 max_load = MAP_MAX_LOAD) {
+    assert(max_load > 0 && max_load < 1);
+
+    u32 cap = 8;
+    while (cap < nslots) {
+        cap *= 2;
+    }
+    DenseMap map = {};
+    map.max_load = max_load;
+    map.a_grow = a_dest;
+    map.gen = 1;
+    _DenseAlloc(&map, cap);
+    return map;
 }
-f32 Rand01_f32() {
-    f32 randnum = (f32) Kiss_Random(g_kiss_randstate);
-    randnum /= (f32) ULONG_MAX + 1;
-    return randnum;
+
+s64 _DenseFind(DenseMap *map, u64 key) {
+    // index slot of key, or -1
+    u64 idx = _DenseHome(map, key);
+    while (map->index[idx].gen == map->gen) {
+        if (map->entries[map->index[idx].entry].key == key) {
+            return (s64) idx;
+        }
+        idx = (idx + 1) & map->mask;
+    }
+    return -1;
 }
-f32 RandPM1_f32() {
-    f32 randnum = (f32) Kiss_Random(g_kiss_randstate);
-    randnum /= ((f32) ULONG_MAX + 1) / 2;
-    randnum -= 1;
-    return randnum;
+
+void _DenseReindex(DenseMap *map, u32 nslots) {
+    // moves the live entries, in order and without holes, to the front of a table of nslots and rebuilds the index
+    DenseEntry *src = map->entries;
+    u32 used = map->used;
+    if (nslots == map->mask + 1) {
+        map->gen++;
+        if (map->gen == 0) {
+            memset(map->index, 0, sizeof(DenseSlot) * nslots);
+            map->gen = 1;
+        }
+    }
+    else {
+        _DenseAlloc(map, nslots);
+    }
+    map->used = 0;
+    for (u32 i = 0; i < used; ++i) {
+        if (src[i].key) {
+            map->entries[map->used++] = src[i];
+        }
+    }
+    for (u32 i = 0; i < map->used; ++i) {
+        u64 idx = _DenseHome(map, map->entries[i].key);
+        while (map->index[idx].gen == map->gen) {
+            idx = (idx + 1) & map->mask;
+        }
+        map->index[idx] = DenseSlot { map->gen, i };
+    }
 }
-int RandMinMaxI(int min, int max) {
-    assert(max > min);
-    return Kiss_Random(g_kiss_randstate) % (max - min + 1) + min;
+
+s64 MapPut(DenseMap *map, u64 key, u64 val) {
+    // inserts at the end or overwrites in place, returns the entry's position
+    assert(key != 0);
+
+    s64 found = _DenseFind(map, key);
+    if (found >= 0) {
+        u32 entry = map->index[found].entry;
+        map->entries[entry].val = val;
+        return entry;
+    }
+    if (map->used == map->cap) {
+        _DenseReindex(map, (u32) (map->mask + 1) * 2);
+    }
+
+    u32 entry = map->used++;
+    map->entries[entry] = DenseEntry { key, val };
+    u64 idx = _DenseHome(map, key);
+    while (map->index[idx].gen == map->gen) {
+        idx = (idx + 1) & map->mask;
+    }
+    map->index[idx] = DenseSlot { map->gen, entry };
+    map->len++;
+    return entry;
 }
-u32 RandMinMaxU(u32 min, u32 max) {
-    assert(max > min);
-    return Kiss_Random(g_kiss_randstate) % (max - min + 1) + min;
+
+u64 MapGet(DenseMap *map, u64 key) {
+    if (key == 0) {
+        return 0;
+    }
+    s64 found = _DenseFind(map, key);
+    return (found >= 0) ? map->entries[map->index[found].entry].val : 0;
 }
-u32 RandMinU16(u32 min) {
-    return RandMinMaxU(min, (u16) -1);
+
+s64 MapRemove(DenseMap *map, u64 key) {
+    // -1 if absent, otherwise the entry index the key had, which a compaction triggered by this remove may re-use
+    if (key == 0) {
+        return -1;
+    }
+    s64 found = _DenseFind(map, key);
+    if (found < 0) {
+        return -1;
+    }
+    u32 entry = map->index[found].entry;
+    map->entries[entry] = DenseEntry {};
+    map->len--;
+
+    // backward-shift the rest of the index run
+    u64 hole = (u64) found;
+    u64 idx = hole;
+    while (true) {
+        idx = (idx + 1) & map->mask;
+        if (map->index[idx].gen != map->gen) {
+            break;
+        }
+        u64 home = _DenseHome(map, map->entries[map->index[idx].entry].key);
+        if (((idx - home) & map->mask) >= ((idx - hole) & map->mask)) {
+            map->index[hole] = map->index[idx];
+            hole = idx;
+        }
+    }
+    map->index[hole].gen = 0;
+
+    if (map->used - map->len > map->used / 4) {
+        _DenseReindex(map, (u32) (map->mask + 1));
+    }
+    return (s64) entry;
 }
-f32 RandMinMaxI_f32(int min, int max) {
-    assert(max > min);
-    return (f32) (Kiss_Random(g_kiss_randstate) % (max - min + 1) + min);
+
+void MapClear(DenseMap *map) {
+    // O(1), keeps the tables
+    map->len = 0;
+    map->used = 0;
+    map->gen++;
+    if (map->gen == 0) {
+        memset(map->index, 0, sizeof(DenseSlot) * (map->mask + 1));
+        map->gen = 1;
+    }
 }
-int RandDice(u32 max) {
-    assert(max > 0);
-    return Kiss_Random(g_kiss_randstate) % max + 1;
+
+DenseEntry *MapNext(DenseMap *map, MapIter *iter) {
+    // NULL when done, entries come in insertion order
+    while ((u32) iter->slot_idx < map->used) {
+        DenseEntry *e = map->entries + iter->slot_idx++;
+        if (e->key) {
+            iter->occ_slots_cnt++;
+            return e;
+        }
+    }
+    return NULL;
 }
-int RandIntMax(u32 max) {
-    assert(max > 0);
-    return Kiss_Random(g_kiss_randstate) % max + 1;
+
+
+//
+//  Flat hash map (SwissTable layout)
+//
+//  Open addressing over 16-byte key/value slots with a parallel array of control bytes: 7 bits of the hash for a
+//  full slot, or EMPTY / DELETED. A probe compares a whole group of control bytes (16 with SSE2, 32 with AVX2)
+//  against the hash tag at once and touches only the slots that match, so most lookups cost one control-byte load
+//  and one slot load. Groups are probed triangularly, which visits every group of a power-of-two table. Removes
+//  leave DELETED tombstones that are dropped when the table is rebuilt. All keys are valid, including 0.
+//  Takes the MapPut/MapGet/MapRemove/MapClear call shapes of HashMap.
+
+
+#if SIMD_AVX2
+    #define SWISS_GROUP 32
+#else
+    #define SWISS_GROUP 16
+#endif
+#define SWISS_EMPTY 0x80
+#define SWISS_DELETED 0xFE
+#define SWISS_MAX_LOAD 0.875f
+
+inline
+u64 _SwissHash(u64 key) {
+    // one multiply, folded so that the tag (low 7 bits) and the position (bits 7 and up) both see the high bits
+    u64 hash = key * 0x9E3779B97F4A7C15ull;
+    return hash ^ (hash >> 32);
+}
+
+struct SwissSlot {
+    u64 key;
+    u64 val;
+};
+
+struct SwissMap {
+    u8 *ctrl;           // cap + SWISS_GROUP bytes, the tail mirrors the first group for wrap-around loads
+    SwissSlot *slots;
+    u64 mask;           // cap - 1
+    u32 len;
+    u32 deleted;
+    f32 max_load;
+    MArena *a_grow;     // NULL for a fixed-size map
+    u32 grows;
+
+    u64 Cap() {
+        return mask + 1;
+    }
+    void Print() {
+        printf("len: %u, deleted: %u, cap: %lu, grows: %u\n", len, deleted, Cap(), grows);
+    }
+};
+
+inline
+u32 _SwissMatch(u8 *group, u8 tag) {
+    // bit i set where group[i] == tag
+    #if SIMD_AVX2
+    __m256i ctrl = _mm256_loadu_si256((__m256i*) group);
+    return (u32) _mm256_movemask_epi8(_mm256_cmpeq_epi8(ctrl, _mm256_set1_epi8((char) tag)));
+    #elif SIMD_SSE2
+    __m128i ctrl = _mm_loadu_si128((__m128i*) group);
+    return (u32) _mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8((char) tag)));
+    #else
+    u32 mask = 0;
+    for (u32 i = 0; i < SWISS_GROUP; ++i) {
+        mask |= (u32) (group[i] == tag) << i;
+    }
+    return mask;
+    #endif
+}
+
+inline
+u32 _SwissMatchVacant(u8 *group) {
+    // EMPTY and DELETED are the control bytes with the top bit set
+    #if SIMD_AVX2
+    return (u32) _mm256_movemask_epi8(_mm256_loadu_si256((__m256i*) group));
+    #elif SIMD_SSE2
+    return (u32) _mm_movemask_epi8(_mm_loadu_si128((__m128i*) group));
+    #else
+    u32 mask = 0;
+    for (u32 i = 0; i < SWISS_GROUP; ++i) {
+        mask |= (u32) (group[i] >> 7) << i;
+    }
+    return mask;
+    #endif
+}
+
+inline
+void _SwissSetCtrl(SwissMap *map, u64 idx, u8 ctrl) {
+    map->ctrl[idx] = ctrl;
+    if (idx < SWISS_GROUP) {
+        map->ctrl[map->mask + 1 + idx] = ctrl;
+    }
+}
+
+void _SwissAlloc(MArena *a_dest, SwissMap *map, u64 cap) {
+    map->ctrl = (u8*) ArenaAlloc(a_dest, cap + SWISS_GROUP, false);
+    memset(map->ctrl, SWISS_EMPTY, cap + SWISS_GROUP);
+    map->slots = (SwissSlot*) ArenaAllocAligned(a_dest, sizeof(SwissSlot) * cap, CACHE_LINE_SIZE, false);
+    map->mask = cap - 1;
+    map->len = 0;
+    map->deleted = 0;
+}
+
+SwissMap InitSwissMap(MArena *a_dest, u32 cap = 1024, bool grow = true, f32 max_load = SWISS_MAX_LOAD) {
+    // cap is rounded up to a power of two of at least two groups
+    assert(max_load > 0 && max_load < 1);
+
+    u64 pow2 = 2 * SWISS_GROUP;
+    while (pow2 < cap) {
+        pow2 *= 2;
+    }
+    SwissMap map = {};
+    map.max_load = max_load;
+    map.a_grow = grow ? a_dest : NULL;
+    _SwissAlloc(a_dest, &map, pow2);
+    return map;
+}
+
+void MapClear(SwissMap *map) {
+    memset(map->ctrl, SWISS_EMPTY, map->mask + 1 + SWISS_GROUP);
+    map->len = 0;
+    map->deleted = 0;
+}
+
+s64 SwissFind(SwissMap *map, u64 key) {
+    // slot index of key, -1 if absent
+    u64 hash = _SwissHash(key);
+    u8 tag = (u8) (hash & 0x7F);
+    u64 pos = (hash >> 7) & map->mask;
+    u64 step = 0;
+
+    while (true) {
+        u8 *group = map->ctrl + pos;
+        u32 match = _SwissMatch(group, tag);
+        while (match) {
+            u64 idx = (pos + CtzU32(match)) & map->mask;
+            if (map->slots[idx].key == key) {
+                return (s64) idx;
+            }
+            match &= match - 1;
+        }
+        if (_SwissMatch(group, SWISS_EMPTY)) {
+            return -1;
+        }
+        step += SWISS_GROUP;
+        pos = (pos + step) & map->mask;
+    }
+}
+
+u64 _SwissFindVacant(SwissMap *map, u64 hash) {
+    // a table below max_load always has an empty slot, so this terminates
+    u64 pos = (hash >> 7) & map->mask;
+    u64 step = 0;
+    while (true) {
+        u32 vacant = _SwissMatchVacant(map->ctrl + pos);
+        if (vacant) {
+            return (pos + CtzU32(vacant)) & map->mask;
+        }
+        step += SWISS_GROUP;
+        pos = (pos + step) & map->mask;
+    }
+}
+
+void _SwissRehash(SwissMap *map, u64 new_cap) {
+    // re-inserts the live slots, dropping tombstones. A growing map moves to a new table and leaves the old one on
+    // the arena, a fixed-size map rebuilds in place from a temporary copy.
+    u64 old_cap = map->Cap();
+    u8 *old_ctrl = map->ctrl;
+    SwissSlot *old_slots = map->slots;
+    u8 *copy = NULL;
+    if (map->a_grow) {
+        _SwissAlloc(map->a_grow, map, new_cap);
+    }
+    else {
+        assert(new_cap == old_cap);
+        copy = (u8*) malloc((sizeof(SwissSlot) + 1) * old_cap);
+        old_slots = (SwissSlot*) copy;
+        old_ctrl = copy + sizeof(SwissSlot) * old_cap;
+        memcpy(old_slots, map->slots, sizeof(SwissSlot) * old_cap);
+        memcpy(old_ctrl, map->ctrl, old_cap);
+        MapClear(map);
+    }
+
+    for (u64 i = 0; i < old_cap; ++i) {
+        if ((old_ctrl[i] & 0x80) == 0) {
+            u64 hash = _SwissHash(old_slots[i].key);
+            u64 idx = _SwissFindVacant(map, hash);
+            _SwissSetCtrl(map, idx, (u8) (hash & 0x7F));
+            map->slots[idx] = old_slots[i];
+            map->len++;
+        }
+    }
+    free(copy);
+}
+
+s64 MapPut(SwissMap *map, u64 key, u64 val) {
+    // inserts or overwrites, returns the slot index or -1 when a fixed-size map is full
+    s64 found = SwissFind(map, key);
+    if (found >= 0) {
+        map->slots[found].val = val;
+        return found;
+    }
+
+    if (map->len + map->deleted + 1 > map->max_load * map->Cap()) {
+        // mostly tombstones: rebuild at the same size, otherwise double
+        bool crowded = (map->len + 1 > map->max_load * map->Cap() / 2);
+        if (map->a_grow == NULL) {
+            if (map->len + 1 > map->max_load * map->Cap()) {
+                return -1;
+            }
+            _SwissRehash(map, map->Cap());
+        }
+        else {
+            _SwissRehash(map, crowded ? 2 * map->Cap() : map->Cap());
+            map->grows += crowded;
+        }
+    }
+
+    u64 hash = _SwissHash(key);
+    u64 idx = _SwissFindVacant(map, hash);
+    map->deleted -= (map->ctrl[idx] == SWISS_DELETED);
+    _SwissSetCtrl(map, idx, (u8) (hash & 0x7F));
+    map->slots[idx].key = key;
+    map->slots[idx].val = val;
+    map->len++;
+
+    return (s64) idx;
+}
+
+inline
+u64 MapGet(SwissMap *map, u64 key) {
+    // 0 if absent, as for the other maps; MapContains tells a stored 0 apart
+    s64 idx = SwissFind(map, key);
+    return (idx >= 0) ? map->slots[idx].val : 0;
+}
+
+inline
+bool MapContains(SwissMap *map, u64 key) {
+    return SwissFind(map, key) >= 0;
+}
+
+s64 MapRemove(SwissMap *map, u64 key) {
+    // returns the freed slot index, -1 if absent
+    s64 idx = SwissFind(map, key);
+    if (idx < 0) {
+        return -1;
+    }
+    _SwissSetCtrl(map, (u64) idx, SWISS_DELETED);
+    map->len--;
+    map->deleted++;
+    return idx;
+}
+
+// wrappers
+inline
+s64 MapPut(SwissMap *map, void *key, void *val) {
+    return MapPut(map, (u64) key, (u64) val);
+}
+inline
+s64 MapPut(SwissMap *map, u64 key, void *val) {
+    return MapPut(map, key, (u64) val);
+}
+inline
+s64 MapPut(SwissMap *map, Str skey, void *val) {
+    return MapPut(map, HashStringValue(skey), (u64) val);
+}
+inline
+u64 MapGet(SwissMap *map, Str skey) {
+    return MapGet(map, HashStringValue(skey));
+}
+inline
+s64 MapRemove(SwissMap *map, Str skey) {
+    return MapRemove(map, HashStringValue(skey));
+}
+
+
+//
+//  Concurrent hash map
+//
+//  u64 -> u64 map shared between threads, with the MapPut/MapGet/MapRemove call shapes of HashMap. Keys are split
+//  over a power-of-two number of shards. Each shard sits on its own cache line and has its own linear-probing
+//  table, writer lock and sequence counter (a seqlock). Writers take the shard lock and make the counter odd while
+//  they move slots. Readers take no lock: they probe between two reads of the counter and retry if it changed.
+//  Overwriting a value is a single atomic store and leaves readers alone. A shard resizes on its own, under its
+//  lock. Replaced tables stay allocated until ConcurrentMapFree, since a reader may still be probing them.
+//  Key 0 is reserved, as in HashMap.
+//
+//  The shard array comes from the arena at init, but shard tables are calloc'ed: shards grow from any writer
+//  thread at any time, under their own lock only, and an MArena is not thread-safe.
+/*
+    ConcurrentMap map = InitConcurrentMap(a);
+    MapPut(&map, key, val);     // any thread
+    u64 val = MapGet(&map, key);
+*/
+
+
+#define CMAP_MAX_LOAD 0.75f
+#define CMAP_SPINS 64
+
+struct CMapSlot {
+    std::atomic<u64> key;
+    std::atomic<u64> val;
+};
+
+struct CMapTable {
+    u64 mask;
+    CMapTable *retired; // the table this one replaced
+    CMapSlot slots[];
+};
+
+struct alignas(CACHE_LINE_SIZE) CMapShard {
+    std::atomic<u32> seq;
+    std::atomic<u32> lock;  // 0: free, 1: locked, 2: locked with sleepers
+    std::atomic<CMapTable*> table;
+    u32 len;
+};
+
+struct ConcurrentMap {
+    CMapShard *shards;
+    u32 shard_mask;
+};
+
+inline
+void _CMapBackoff(u32 *spins) {
+    if (++*spins < CMAP_SPINS) {
+        #if SIMD_SSE2
+        _mm_pause();
+        #endif
+    }
+    else {
+        std::this_thread::yield();
+    }
+}
+
+void _CMapLock(CMapShard *shard) {
+    u32 c = 0;
+    for (u32 spins = 0; spins < CMAP_SPINS; ++spins) {
+        c = 0;
+        if (shard->lock.compare_exchange_weak(c, 1, std::memory_order_acquire, std::memory_order_relaxed)) {
+            return;
+        }
+        #if SIMD_SSE2
+        _mm_pause();
+        #endif
+    }
+    if (c != 2) {
+        c = shard->lock.exchange(2, std::memory_order_acquire);
+    }
+    while (c != 0) {
+        FutexWait(&shard->lock, 2);
+        c = shard->lock.exchange(2, std::memory_order_acquire);
+    }
+}
+
+inline
+void _CMapUnlock(CMapShard *shard) {
+    if (shard->lock.exchange(0, std::memory_order_release) == 2) {
+        FutexWake(&shard->lock, 1);
+    }
+}
+
+inline
+void _CMapWriteBegin(CMapShard *shard) {
+    shard->seq.store(shard->seq.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+}
+
+inline
+void _CMapWriteEnd(CMapShard *shard) {
+    shard->seq.store(shard->seq.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+CMapTable *_CMapAllocTable(u64 cap) {
+    CMapTable *table = (CMapTable*) calloc(1, sizeof(CMapTable) + sizeof(CMapSlot) * cap);
+    table->mask = cap - 1;
+    return table;
+}
+
+inline
+CMapShard *_CMapShard(ConcurrentMap *map, u64 hash) {
+    // the shard takes bits far above those of the slot index
+    return map->shards + ((hash >> 40) & map->shard_mask);
+}
+
+ConcurrentMap InitConcurrentMap(MArena *a_dest, u32 nshards = 64, u32 shard_slots = 64) {
+    // both counts are rounded up to powers of two
+    u32 shards = 1;
+    while (shards < nshards) {
+        shards *= 2;
+    }
+    u64 cap = 8;
+    while (cap < shard_slots) {
+        cap *= 2;
+    }
+
+    ConcurrentMap map = {};
+    map.shard_mask = shards - 1;
+    map.shards = (CMapShard*) ArenaAllocAligned(a_dest, sizeof(CMapShard) * shards, CACHE_LINE_SIZE);
+    for (u32 i = 0; i < shards; ++i) {
+        map.shards[i].table.store(_CMapAllocTable(cap), std::memory_order_relaxed);
+    }
+    std::atomic_thread_fence(std::memory_order_release);
+    return map;
+}
+
+void ConcurrentMapFree(ConcurrentMap *map) {
+    // no other thread may use the map any more
+    for (u32 i = 0; i <= map->shard_mask; ++i) {
+        CMapTable *table = map->shards[i].table.load(std::memory_order_acquire);
+        while (table) {
+            CMapTable *retired = table->retired;
+            free(table);
+            table = retired;
+        }
+    }
+    *map = {};
+}
+
+u64 ConcurrentMapLen(ConcurrentMap *map) {
+    // exact only while no writers are active
+    u64 len = 0;
+    for (u32 i = 0; i <= map->shard_mask; ++i) {
+        _CMapLock(map->shards + i);
+        len += map->shards[i].len;
+        _CMapUnlock(map->shards + i);
+    }
+    return len;
+}
+
+u64 MapGet(ConcurrentMap *map, u64 key) {
+    if (key == 0) {
+        return 0;
+    }
+    u64 hash = Hash64(key);
+    CMapShard *shard = _CMapShard(map, hash);
+
+    u32 spins = 0;
+    while (true) {
+        u32 seq = shard->seq.load(std::memory_order_acquire);
+        if ((seq & 1) == 0) {
+            CMapTable *table = shard->table.load(std::memory_order_acquire);
+            u64 val = 0;
+            u64 idx = hash & table->mask;
+            for (u64 n = 0; n <= table->mask; ++n) {
+                u64 k = table->slots[idx].key.load(std::memory_order_relaxed);
+                if (k == key) {
+                    val = table->slots[idx].val.load(std::memory_order_relaxed);
+                    break;
+                }
+                if (k == 0) {
+                    break;
+                }
+                idx = (idx + 1) & table->mask;
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (shard->seq.load(std::memory_order_relaxed) == seq) {
+                return val;
+            }
+        }
+        _CMapBackoff(&spins);
+    }
+}
+
+s64 MapPut(ConcurrentMap *map, u64 key, u64 val) {
+    // returns the slot index within the key's shard
+    assert(key != 0);
+
+    u64 hash = Hash64(key);
+    CMapShard *shard = _CMapShard(map, hash);
+    _CMapLock(shard);
+
+    CMapTable *table = shard->table.load(std::memory_order_relaxed);
+    u64 idx = hash & table->mask;
+    u64 k;
+    while ((k = table->slots[idx].key.load(std::memory_order_relaxed)) != 0 && k != key) {
+        idx = (idx + 1) & table->mask;
+    }
+    if (k == key) {
+        table->slots[idx].val.store(val, std::memory_order_relaxed);
+        _CMapUnlock(shard);
+        return (s64) idx;
+    }
+
+    _CMapWriteBegin(shard);
+    if (shard->len + 1 > CMAP_MAX_LOAD * (table->mask + 1)) {
+        // grow this shard only
+        CMapTable *grown = _CMapAllocTable(2 * (table->mask + 1));
+        grown->retired = table;
+        for (u64 i = 0; i <= table->mask; ++i) {
+            u64 rk = table->slots[i].key.load(std::memory_order_relaxed);
+            if (rk) {
+                u64 ri = Hash64(rk) & grown->mask;
+                while (grown->slots[ri].key.load(std::memory_order_relaxed)) {
+                    ri = (ri + 1) & grown->mask;
+                }
+                grown->slots[ri].key.store(rk, std::memory_order_relaxed);
+                grown->slots[ri].val.store(table->slots[i].val.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            }
+        }
+        table = grown;
+        shard->table.store(grown, std::memory_order_release);
+
+        idx = hash & table->mask;
+        while (table->slots[idx].key.load(std::memory_order_relaxed)) {
+            idx = (idx + 1) & table->mask;
+        }
+    }
+    table->slots[idx].val.store(val, std::memory_order_relaxed);
+    table->slots[idx].key.store(key, std::memory_order_relaxed);
+    shard->len++;
+    _CMapWriteEnd(shard);
+
+    _CMapUnlock(shard);
+    return (s64) idx;
+}
+
+s64 MapRemove(ConcurrentMap *map, u64 key) {
+    // returns the freed slot index within the key's shard, -1 if absent
+    if (key == 0) {
+        return -1;
+    }
+    u64 hash = Hash64(key);
+    CMapShard *shard = _CMapShard(map, hash);
+    _CMapLock(shard);
+
+    CMapTable *table = shard->table.load(std::memory_order_relaxed);
+    u64 idx = hash & table->mask;
+    u64 k;
+    while ((k = table->slots[idx].key.load(std::memory_order_relaxed)) != 0 && k != key) {
+        idx = (idx + 1) & table->mask;
+    }
+    if (k == 0) {
+        _CMapUnlock(shard);
+        return -1;
+    }
+
+    // backward-shift the rest of the run, readers retry around it
+    _CMapWriteBegin(shard);
+    u64 removed = idx;
+    u64 hole = idx;
+    while (true) {
+        idx = (idx + 1) & table->mask;
+        u64 nk = table->slots[idx].key.load(std::memory_order_relaxed);
+        if (nk == 0) {
+            break;
+        }
+        u64 home = Hash64(nk) & table->mask;
+        if (((idx - home) & table->mask) >= ((idx - hole) & table->mask)) {
+            table->slots[hole].key.store(nk, std::memory_order_relaxed);
+            table->slots[hole].val.store(table->slots[idx].val.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            hole = idx;
+        }
+    }
+    table->slots[hole].key.store(0, std::memory_order_relaxed);
+    table->slots[hole].val.store(0, std::memory_order_relaxed);
+    shard->len--;
+    _CMapWriteEnd(shard);
+
+    _CMapUnlock(shard);
+    return (s64) removed;
+}
+
+// wrappers
+inline
+s64 MapPut(ConcurrentMap *map, void *key, void *val) {
+    return MapPut(map, (u64) key, (u64) val);
+}
+inline
+s64 MapPut(ConcurrentMap *map, u64 key, void *val) {
+    return MapPut(map, key, (u64) val);
+}
+inline
+s64 MapPut(ConcurrentMap *map, Str skey, void *val) {
+    return MapPut(map, HashStringValue(skey), (u64) val);
+}
+inline
+u64 MapGet(ConcurrentMap *map, Str skey) {
+    return MapGet(map, HashStringValue(skey));
+}
+inline
+s64 MapRemove(ConcurrentMap *map, Str skey) {
+    return MapRemove(map, HashStringValue(skey));
+}
+
+
+//
+//  Typed hash map
+//
+//  Open addressing with keys and values stored inline in the slots, so a lookup touches a single run of slots
+//  instead of a KeyVal plus a pooled value elsewhere. Slots are exactly { K key; V val; }, e.g. 8 bytes for a
+//  u32 -> u32 map. As with HashMap's key 0, the zero key K{} is reserved to mark empty slots. Probing is linear
+//  and removes shift the following run back, so there are no tombstones.
+//
+//  The Hasher supplies static Hash() and Equal() and is resolved at compile time. The map applies a Fibonacci
+//  multiply on top, so Hash() may return the key itself for integers. The default HasherT compares and hashes
+//  raw bytes, so struct keys with padding need their own hasher.
+/*
+    HashMapT<u64, Particle> map = InitHashMapT<u64, Particle>(a);
+    map.Put(id, particle);
+    Particle *p = map.Get(id);
+*/
+
+
+template<typename K>
+struct HasherT {
+    static u64 Hash(K key) {
+        return HashBytes(&key, sizeof(K));
+    }
+    static bool Equal(K a, K b) {
+        return memcmp(&a, &b, sizeof(K)) == 0;
+    }
+};
+
+template<>
+struct HasherT<u32> {
+    static u64 Hash(u32 key) { return key; }
+    static bool Equal(u32 a, u32 b) { return a == b; }
+};
+
+template<>
+struct HasherT<u64> {
+    static u64 Hash(u64 key) { return key; }
+    static bool Equal(u64 a, u64 b) { return a == b; }
+};
+
+template<typename K, typename V, typename Hasher = HasherT<K>>
+struct HashMapT {
+    struct Slot {
+        K key;
+        V val;
+    };
+
+    Slot *slots;
+    u32 len;
+    u32 shift;          // 64 - log2(capacity)
+    u64 mask;
+    f32 max_load;
+    MArena *a_grow;     // NULL for a fixed-size map
+
+    inline
+    u64 Cap() {
+        return mask + 1;
+    }
+    inline
+    bool _IsEmpty(Slot *slot) {
+        return Hasher::Equal(slot->key, K {});
+    }
+    inline
+    u64 _Home(K key) {
+        return (Hasher::Hash(key) * 0x9E3779B97F4A7C15ull) >> shift;
+    }
+    void _Alloc(u64 cap) {
+        slots = (Slot*) ArenaAllocAligned(a_grow, sizeof(Slot) * cap, CACHE_LINE_SIZE);
+        mask = cap - 1;
+        shift = 64;
+        while (cap > 1) {
+            cap >>= 1;
+            shift--;
+        }
+    }
+    void _Grow() {
+        // doubles into a new table, the old one stays on the arena
+        Slot *old = slots;
+        u64 old_cap = Cap();
+        _Alloc(2 * old_cap);
+        for (u64 i = 0; i < old_cap; ++i) {
+            if (_IsEmpty(old + i) == false) {
+                u64 idx = _Home(old[i].key);
+                while (_IsEmpty(slots + idx) == false) {
+                    idx = (idx + 1) & mask;
+                }
+                slots[idx] = old[i];
+            }
+        }
+    }
+
+    s64 _Find(K key) {
+        u64 idx = _Home(key);
+        while (true) {
+            Slot *slot = slots + idx;
+            if (_IsEmpty(slot)) {
+                return -1;
+            }
+            if (Hasher::Equal(slot->key, key)) {
+                return (s64) idx;
+            }
+            idx = (idx + 1) & mask;
+        }
+    }
+    V *Get(K key) {
+        // pointer to the inline value, NULL if absent
+        s64 idx = _Find(key);
+        return (idx >= 0) ? &slots[idx].val : NULL;
+    }
+    bool Contains(K key) {
+        return Get(key) != NULL;
+    }
+    V *Put(K key, V val) {
+        // inserts or overwrites, returns the stored value or NULL when a fixed-size map is full
+        assert(Hasher::Equal(key, K {}) == false && "HashMapT: the zero key is reserved");
+
+        V *found = Get(key);
+        if (found) {
+            *found = val;
+            return found;
+        }
+        if (len + 1 > max_load * Cap()) {
+            if (a_grow == NULL) {
+                return NULL;
+            }
+            _Grow();
+        }
+
+        u64 idx = _Home(key);
+        while (_IsEmpty(slots + idx) == false) {
+            idx = (idx + 1) & mask;
+        }
+        slots[idx].key = key;
+        slots[idx].val = val;
+        len++;
+        return &slots[idx].val;
+    }
+    bool Remove(K key) {
+        s64 found = _Find(key);
+        if (found < 0) {
+            return false;
+        }
+
+        // backward-shift: pull later entries of the run into the hole unless that moves them before their home
+        u64 hole = (u64) found;
+        u64 idx = hole;
+        while (true) {
+            idx = (idx + 1) & mask;
+            if (_IsEmpty(slots + idx)) {
+                break;
+            }
+            u64 home = _Home(slots[idx].key);
+            if (((idx - home) & mask) >= ((idx - hole) & mask)) {
+                slots[hole] = slots[idx];
+                hole = idx;
+            }
+        }
+        slots[hole] = Slot {};
+        len--;
+        return true;
+    }
+    void Clear() {
+        memset(slots, 0, sizeof(Slot) * Cap());
+        len = 0;
+    }
+};
+
+template<typename K, typename V, typename Hasher = HasherT<K>>
+HashMapT<K, V, Hasher> InitHashMapT(MArena *a_dest, u32 nslots = 1024, bool grow = true, f32 max_load = MAP_MAX_LOAD) {
+    // nslots is rounded up to a power of two
+    assert(max_load > 0 && max_load < 1);
+
+    u64 cap = 8;
+    while (cap < nslots) {
+        cap *= 2;
+    }
+    HashMapT<K, V, Hasher> map = {};
+    map.max_load = max_load;
+    map.a_grow = a_dest;
+    map._Alloc(cap);
+    map.a_grow = grow ? a_dest : NULL;
+    return map;
+}
+
+
+//
+//  String-keyed hash map
+//
+//  Keeps the key bytes, unlike MapPut(HashMap*, Str, ...), which only stores the string's hash. Slots hold the
+//  full 64-bit hash plus an offset and length into a key blob on a separate arena, and the bytes are compared only
+//  when the hashes match. Probing is linear, so a miss mostly costs one cache line of slots. Growth re-uses the
+//  stored hashes and never touches the blob. Removed keys leave their bytes in the blob.
+/*
+    StrMap map = InitStrMap(a, a_keys);
+    StrMapPut(&map, StrL("identifier"), 42);
+    u64 val = StrMapGet(&map, StrL("identifier"));
+*/
+
+
+struct StrMapSlot {
+    u64 hash;   // 0 marks an empty slot
+    u64 val;
+    u32 offset;
+    u32 len;
+};
+
+struct StrMap {
+    StrMapSlot *slots;
+    u64 mask;
+    u32 len;
+    u32 shift;
+    f32 max_load;
+    MArena *a_grow;
+    MArena *a_keys;
+
+    inline
+    u64 Cap() {
+        return mask + 1;
+    }
+    inline
+    Str Key(u64 idx) {
+        return Str { (char*) a_keys->mem + slots[idx].offset, slots[idx].len };
+    }
+};
+
+inline
+u64 _StrMapHash(Str key) {
+    u64 hash = HashStringValue(key);
+    return hash ? hash : 1;
+}
+
+void _StrMapAlloc(StrMap *map, u64 cap) {
+    map->slots = (StrMapSlot*) ArenaAllocAligned(map->a_grow, sizeof(StrMapSlot) * cap, CACHE_LINE_SIZE);
+    map->mask = cap - 1;
+    map->shift = 64;
+    while (cap > 1) {
+        cap >>= 1;
+        map->shift--;
+    }
+}
+
+StrMap InitStrMap(MArena *a_dest, MArena *a_keys, u32 nslots = 1024, f32 max_load = MAP_MAX_LOAD) {
+    // slots grow on a_dest, key bytes are appended to a_keys
+    assert(max_load > 0 && max_load < 1);
+
+    u64 cap = 8;
+    while (cap < nslots) {
+        cap *= 2;
+    }
+    StrMap map = {};
+    map.max_load = max_load;
+    map.a_grow = a_dest;
+    map.a_keys = a_keys;
+    _StrMapAlloc(&map, cap);
+    return map;
+}
+
+inline
+u64 _StrMapHome(StrMap *map, u64 hash) {
+    return (hash * 0x9E3779B97F4A7C15ull) >> map->shift;
+}
+
+s64 StrMapFind(StrMap *map, Str key, u64 hash) {
+    u64 idx = _StrMapHome(map, hash);
+    while (true) {
+        StrMapSlot *slot = map->slots + idx;
+        if (slot->hash == 0) {
+            return -1;
+        }
+        if (slot->hash == hash && slot->len == key.len && memcmp(map->a_keys->mem + slot->offset, key.str, key.len) == 0) {
+            return (s64) idx;
+        }
+        idx = (idx + 1) & map->mask;
+    }
+}
+
+inline
+s64 StrMapFind(StrMap *map, Str key) {
+    return StrMapFind(map, key, _StrMapHash(key));
+}
+
+void StrMapReserve(StrMap *map, u32 cnt) {
+    // grows once to hold cnt keys below max_load, re-using the stored hashes
+    u64 cap = map->Cap();
+    while (cnt > map->max_load * cap) {
+        cap *= 2;
+    }
+    if (cap == map->Cap()) {
+        return;
+    }
+
+    StrMapSlot *old = map->slots;
+    u64 old_cap = map->Cap();
+    _StrMapAlloc(map, cap);
+    for (u64 i = 0; i < old_cap; ++i) {
+        if (old[i].hash) {
+            u64 idx = _StrMapHome(map, old[i].hash);
+            while (map->slots[idx].hash) {
+                idx = (idx + 1) & map->mask;
+            }
+            map->slots[idx] = old[i];
+        }
+    }
+}
+
+s64 _StrMapAdd(StrMap *map, Str key, u64 hash, u64 val, u8 *bytes) {
+    // adds a key known to be absent; bytes already in the blob are referenced, NULL copies the key there
+    if (map->len + 1 > map->max_load * map->Cap()) {
+        StrMapReserve(map, map->len + 1);
+    }
+    if (bytes == NULL) {
+        bytes = (u8*) ArenaAlloc(map->a_keys, key.len, false);
+        memcpy(bytes, key.str, key.len);
+    }
+    u64 offset = bytes - map->a_keys->mem;
+    assert(offset + key.len <= 0xFFFFFFFF && "StrMap: key blob exceeds 4GB");
+
+    u64 idx = _StrMapHome(map, hash);
+    while (map->slots[idx].hash) {
+        idx = (idx + 1) & map->mask;
+    }
+    map->slots[idx] = StrMapSlot { hash, val, (u32) offset, key.len };
+    map->len++;
+    return (s64) idx;
+}
+
+s64 StrMapPut(StrMap *map, Str key, u64 val) {
+    // inserts or overwrites, returns the slot index
+    u64 hash = _StrMapHash(key);
+    s64 found = StrMapFind(map, key, hash);
+    if (found >= 0) {
+        map->slots[found].val = val;
+        return found;
+    }
+    return _StrMapAdd(map, key, hash, val, NULL);
+}
+
+u64 StrMapGet(StrMap *map, Str key) {
+    // 0 if absent, like MapGet
+    s64 idx = StrMapFind(map, key);
+    return (idx >= 0) ? map->slots[idx].val : 0;
+}
+
+inline
+bool StrMapContains(StrMap *map, Str key) {
+    return StrMapFind(map, key) >= 0;
+}
+
+bool StrMapRemove(StrMap *map, Str key) {
+    s64 found = StrMapFind(map, key);
+    if (found < 0) {
+        return false;
+    }
+
+    // backward-shift the rest of the run, no tombstones
+    u64 hole = (u64) found;
+    u64 idx = hole;
+    while (true) {
+        idx = (idx + 1) & map->mask;
+        if (map->slots[idx].hash == 0) {
+            break;
+        }
+        u64 home = _StrMapHome(map, map->slots[idx].hash);
+        if (((idx - home) & map->mask) >= ((idx - hole) & map->mask)) {
+            map->slots[hole] = map->slots[idx];
+            hole = idx;
+        }
+    }
+    map->slots[hole] = StrMapSlot {};
+    map->len--;
+    return true;
+}
+
+void StrMapBulkLoad(StrMap *map, Str *keys, u64 *vals, u32 cnt) {
+    // sizes the table once and packs all key bytes back to back in one blob allocation, without length prefixes
+    // or terminators; vals may be NULL to store each key's position in keys + 1
+    StrMapReserve(map, map->len + cnt);
+
+    u64 nbytes = 0;
+    for (u32 i = 0; i < cnt; ++i) {
+        nbytes += keys[i].len;
+    }
+    u8 *blob = (u8*) ArenaAlloc(map->a_keys, nbytes, false);
+    u8 *at = blob;
+    for (u32 i = 0; i < cnt; ++i) {
+        u64 hash = _StrMapHash(keys[i]);
+        u64 val = vals ? vals[i] : i + 1;
+        s64 found = StrMapFind(map, keys[i], hash);
+        if (found >= 0) {
+            map->slots[found].val = val;
+            continue;
+        }
+        memcpy(at, keys[i].str, keys[i].len);
+        _StrMapAdd(map, keys[i], hash, val, at);
+        at += keys[i].len;
+    }
+
+    // duplicates were not copied
+    if (map->a_keys->mem + map->a_keys->used == blob + nbytes) {
+        map->a_keys->used -= (blob + nbytes) - at;
+    }
+}
+
+void StrMapBulkLoad(StrMap *map, StrLst *keys) {
+    // values are the keys' positions in the list + 1
+    u32 cnt = 0;
+    for (StrLst *k = keys; k; k = k->next) {
+        cnt++;
+    }
+    Str *arr = (Str*) malloc(sizeof(Str) * MaxU32(cnt, 1));
+    cnt = 0;
+    for (StrLst *k = keys; k; k = k->next) {
+        arr[cnt++] = k->GetStr();
+    }
+    StrMapBulkLoad(map, arr, NULL, cnt);
+    free(arr);
+}
+
+// wrappers
+inline
+s64 StrMapPut(StrMap *map, Str key, void *val) {
+    return StrMapPut(map, key, (u64) val);
+}
+inline
+s64 StrMapPut(StrMap *map, const char *key, u64 val) {
+    return StrMapPut(map, StrL(key), val);
+}
+inline
+u64 StrMapGet(StrMap *map, const char *key) {
+    return StrMapGet(map, StrL(key));
+}
+
+
+//
+//  String interning
+//
+//  Deduplicates strings through a StrMap and hands out dense u32 symbol ids, 0, 1, 2, ... in order of first
+//  appearance. Each distinct string is stored once in the key blob, and the Str returned for it stays valid for
+//  the blob arena's lifetime, so interned strings compare equal exactly when their ids (or str pointers) do.
+//  Ids resolve back to strings through a bucket array indexed by id. Interned strings are never removed.
+/*
+    StrInterns syms = InitStrInterns(a, a_keys);
+    u32 id = StrInternId(&syms, StrL("identifier"));
+    Str s = StrInternGet(&syms, id);
+*/
+
+
+#define STR_INTERN_NONE 0xFFFFFFFF
+
+struct StrInterns {
+    StrMap map;             // string -> id + 1
+    BucketArray<Str> strs;  // id -> string in the key blob
+
+    inline
+    u32 Len() {
+        return strs.len;
+    }
+};
+
+StrInterns InitStrInterns(MArena *a_dest, MArena *a_keys, u32 nslots = 1024) {
+    StrInterns interns = {};
+    interns.map = InitStrMap(a_dest, a_keys, nslots);
+    interns.strs = InitBucketArray<Str>(a_dest, 1024);
+    return interns;
+}
+
+u32 StrInternId(StrInterns *interns, Str s) {
+    // id of s, adding it on first sight
+    u64 hash = _StrMapHash(s);
+    s64 found = StrMapFind(&interns->map, s, hash);
+    if (found >= 0) {
+        return (u32) interns->map.slots[found].val - 1;
+    }
+    u32 id = interns->strs.len;
+    assert(id != STR_INTERN_NONE && "StrInterns: out of ids");
+    s64 idx = _StrMapAdd(&interns->map, s, hash, (u64) id + 1, NULL);
+    interns->strs.Add(interns->map.Key(idx));
+    return id;
+}
+
+inline
+u32 StrInternLookup(StrInterns *interns, Str s) {
+    // id of s without adding it, STR_INTERN_NONE if it was never interned
+    return (u32) StrMapGet(&interns->map, s) - 1;
+}
+
+inline
+Str StrInternGet(StrInterns *interns, u32 id) {
+    return interns->strs.Get(id);
+}
+
+inline
+Str StrIntern(StrInterns *interns, Str s) {
+    // the one stored copy of s
+    return StrInternGet(interns, StrInternId(interns, s));
+}
+
+inline
+u32 StrInternId(StrInterns *interns, const char *s) {
+    return StrInternId(interns, StrL(s));
+}
+
+
+//
+//  Minimal perfect hash
+//
+//  Maps each key of a fixed set of n keys to its own index in [0, n), PTHash-style: keys are hashed into
+//  buckets, 60% of them into the first 30% of buckets, and every bucket stores a pilot value chosen at build time
+//  so that its keys land on free positions of a table of n / PH_ALPHA slots. The few positions at or beyond n are
+//  remapped to the holes left below n. A lookup is two hashes, a pilot load and (rarely) a remap load, with no
+//  probing and no stored keys, so keys outside the set map to arbitrary indices. Pilots take ~1.2 bytes per key
+//  at 10M keys. Hashes are HashBytes / Hash64, which are the same on every platform. The serialized blob is written
+//  in host byte order and used in place, so it loads on any host of the same byte order (all little-endian
+//  targets); PerfectHashLoad rejects a blob from the other byte order by its magic number.
+/*
+    PerfectHash ph = PerfectHashBuild(a, keys);     // List<u64>, or Str *keys and a count
+    u32 idx = PerfectHashIdx(&ph, key);             // e.g. into a values array of keys.len entries
+
+    u64 size;
+    u8 *blob = PerfectHashSerialize(a, &ph, &size);
+    PerfectHash loaded = PerfectHashLoad(blob, size);
+*/
+
+
+#define PH_ALPHA 0.99               // load factor of the position table
+#define PH_BUCKET_C 7.0             // average bucket size is log2(n) / c
+#define PH_DENSE_KEYS 0x9999999Au   // 60% of the low 32 hash bits: keys going into the dense buckets
+#define PH_MAGIC 0x48504C42         // "BLPH"
+#define PH_VERSION 1
+
+struct PerfectHash {
+    u64 seed;
+    u32 nkeys;
+    u32 nbuckets;
+    u32 table_len;
+    u32 dense_buckets;
+    u32 *pilots;    // nbuckets
+    u32 *remap;     // table_len - nkeys
+};
+
+struct PerfectHashHdr {
+    u32 magic;
+    u32 version;
+    u64 seed;
+    u32 nkeys;
+    u32 nbuckets;
+    u32 table_len;
+    u32 dense_buckets;
+};
+
+inline
+u64 _MulHi(u64 a, u64 b) {
+    // (a * b) >> 64, which maps a uniformly onto [0, b) without a division
+    _WyMum(&a, &b);
+    return b;
+}
+
+inline
+u32 _PerfectHashBucket(PerfectHash *ph, u64 hash) {
+    u32 dense = (u32) _MulHi(hash, ph->dense_buckets);
+    u32 sparse = ph->dense_buckets + (u32) _MulHi(hash, ph->nbuckets - ph->dense_buckets);
+    return ((u32) hash < PH_DENSE_KEYS) ? dense : sparse;
+}
+
+inline
+u64 _PerfectHashPos(PerfectHash *ph, u64 hash, u32 pilot) {
+    return _MulHi(Hash64(hash ^ (pilot * 0x9E3779B97F4A7C15ull)), ph->table_len);
+}
+
+inline
+u32 _PerfectHashIdx(PerfectHash *ph, u64 hash) {
+    u64 pos = _PerfectHashPos(ph, hash, ph->pilots[_PerfectHashBucket(ph, hash)]);
+    return (pos < ph->nkeys) ? (u32) pos : ph->remap[pos - ph->nkeys];
+}
+
+inline
+u64 _PerfectHashKey(u64 key, u64 seed) {
+    // a bijection for any seed, distinct keys never share a hash
+    return Hash64(key ^ (seed * 0x9E3779B97F4A7C15ull));
+}
+
+inline
+u64 _PerfectHashKey(Str key, u64 seed) {
+    return HashBytes(key.str, key.len, seed);
+}
+
+inline
+u32 PerfectHashIdx(PerfectHash *ph, u64 key) {
+    return _PerfectHashIdx(ph, _PerfectHashKey(key, ph->seed));
+}
+
+inline
+u32 PerfectHashIdx(PerfectHash *ph, Str key) {
+    return _PerfectHashIdx(ph, _PerfectHashKey(key, ph->seed));
+}
+
+bool _PerfectHashPlace(MArena *a_dest, PerfectHash *ph, u64 *hashes) {
+    // false if two keys share a hash, the caller retries with another seed
+    u32 n = ph->nkeys;
+    u32 nb = ph->nbuckets;
+
+    // group hashes by bucket (counting sort)
+    u32 *bucket_of = (u32*) malloc(sizeof(u32) * n);
+    u32 *starts = (u32*) calloc(nb + 1, sizeof(u32));
+    u64 *grouped = (u64*) malloc(sizeof(u64) * n);
+    for (u32 i = 0; i < n; ++i) {
+        bucket_of[i] = _PerfectHashBucket(ph, hashes[i]);
+        starts[bucket_of[i] + 1]++;
+    }
+    u32 max_size = 0;
+    for (u32 b = 0; b < nb; ++b) {
+        max_size = MaxU32(max_size, starts[b + 1]);
+        starts[b + 1] += starts[b];
+    }
+    u32 *fill = (u32*) malloc(sizeof(u32) * nb);
+    memcpy(fill, starts, sizeof(u32) * nb);
+    for (u32 i = 0; i < n; ++i) {
+        grouped[fill[bucket_of[i]]++] = hashes[i];
+    }
+
+    // largest buckets first (counting sort by size), they are the hardest to place
+    u32 *size_starts = (u32*) calloc(max_size + 2, sizeof(u32));
+    for (u32 b = 0; b < nb; ++b) {
+        size_starts[max_size - (starts[b + 1] - starts[b]) + 1]++;
+    }
+    for (u32 s = 0; s <= max_size; ++s) {
+        size_starts[s + 1] += size_starts[s];
+    }
+    u32 *order = bucket_of; // re-used, n >= nb is not guaranteed
+    if (nb > n) {
+        order = (u32*) realloc(bucket_of, sizeof(u32) * nb);
+    }
+    for (u32 b = 0; b < nb; ++b) {
+        order[size_starts[max_size - (starts[b + 1] - starts[b])]++] = b;
+    }
+
+    u64 *taken = (u64*) calloc((ph->table_len + 63) / 64, sizeof(u64));
+    u64 *pos = (u64*) malloc(sizeof(u64) * MaxU32(max_size, 1));
+    ph->pilots = (u32*) ArenaAlloc(a_dest, sizeof(u32) * nb);
+    bool ok = true;
+    for (u32 o = 0; o < nb && ok; ++o) {
+        u32 b = order[o];
+        u64 *keys = grouped + starts[b];
+        u32 cnt = starts[b + 1] - starts[b];
+        if (cnt == 0) {
+            break;
+        }
+        for (u32 i = 0; i < cnt && ok; ++i) {
+            for (u32 j = i + 1; j < cnt; ++j) {
+                ok = ok && (keys[i] != keys[j]);
+            }
+        }
+
+        // first pilot whose positions are all free and distinct, bits are taken as we go and rolled back on a clash
+        for (u32 pilot = 0; ok; ++pilot) {
+            u32 placed = 0;
+            for (; placed < cnt; ++placed) {
+                u64 p = _PerfectHashPos(ph, keys[placed], pilot);
+                if (taken[p >> 6] & (1ull << (p & 63))) {
+                    break;
+                }
+                taken[p >> 6] |= 1ull << (p & 63);
+                pos[placed] = p;
+            }
+            if (placed == cnt) {
+                ph->pilots[b] = pilot;
+                break;
+            }
+            for (u32 i = 0; i < placed; ++i) {
+                taken[pos[i] >> 6] &= ~(1ull << (pos[i] & 63));
+            }
+        }
+    }
+
+    // positions at or beyond n take the holes below n, in order
+    if (ok) {
+        ph->remap = (u32*) ArenaAlloc(a_dest, sizeof(u32) * (ph->table_len - n));
+        u32 hole = 0;
+        for (u32 p = n; p < ph->table_len; ++p) {
+            if (taken[p >> 6] & (1ull << (p & 63))) {
+                while (taken[hole >> 6] & (1ull << (hole & 63))) {
+                    hole++;
+                }
+                ph->remap[p - n] = hole++;
+            }
+        }
+    }
+
+    free(pos);
+    free(taken);
+    free(size_starts);
+    free(fill);
+    free(grouped);
+    free(starts);
+    free(order);
+    return ok;
+}
+
+PerfectHash _PerfectHashInit(u32 nkeys, u64 seed) {
+    assert(nkeys > 0);
+
+    f64 log2n = 1;
+    while ((1ull << (u32) log2n) < nkeys) {
+        log2n++;
+    }
+    PerfectHash ph = {};
+    ph.seed = seed;
+    ph.nkeys = nkeys;
+    ph.table_len = MaxU32(nkeys, (u32) (nkeys / PH_ALPHA));
+    ph.nbuckets = MaxU32(2, (u32) (PH_BUCKET_C * nkeys / log2n) + 1);
+    ph.dense_buckets = MaxU32(1, ph.nbuckets * 3 / 10);
+    return ph;
+}
+
+PerfectHash PerfectHashBuild(MArena *a_dest, List<u64> keys) {
+    // keys must be distinct, pilots is NULL otherwise
+    PerfectHash ph = _PerfectHashInit(keys.len, 0);
+    u64 *hashes = (u64*) malloc(sizeof(u64) * keys.len);
+    for (u32 i = 0; i < keys.len; ++i) {
+        hashes[i] = _PerfectHashKey(keys.lst[i], ph.seed);
+    }
+    if (_PerfectHashPlace(a_dest, &ph, hashes) == false) {
+        ph.pilots = NULL;
+    }
+    free(hashes);
+    return ph;
+}
+
+struct _PerfectHashEntry {
+    u64 hash;
+    u32 idx;
+};
+
+int _PerfectHashEntryCmp(const void *a, const void *b) {
+    u64 ha = ((_PerfectHashEntry*) a)->hash;
+    u64 hb = ((_PerfectHashEntry*) b)->hash;
+    return (ha > hb) - (ha < hb);
+}
+
+bool _PerfectHashHasDuplicate(Str *keys, u64 *hashes, u32 cnt) {
+    // byte-equal keys share a hash under every seed, re-seeding can't separate them
+    _PerfectHashEntry *entries = (_PerfectHashEntry*) malloc(sizeof(_PerfectHashEntry) * cnt);
+    for (u32 i = 0; i < cnt; ++i) {
+        entries[i] = { hashes[i], i };
+    }
+    qsort(entries, cnt, sizeof(_PerfectHashEntry), _PerfectHashEntryCmp);
+    bool dup = false;
+    for (u32 i = 0; i + 1 < cnt && dup == false; ++i) {
+        for (u32 j = i + 1; j < cnt && entries[j].hash == entries[i].hash && dup == false; ++j) {
+            dup = StrEqual(keys[entries[i].idx], keys[entries[j].idx]);
+        }
+    }
+    free(entries);
+    return dup;
+}
+
+PerfectHash PerfectHashBuild(MArena *a_dest, Str *keys, u32 cnt) {
+    // keys must be distinct, pilots is NULL otherwise; a 64-bit hash collision between two of them is resolved by
+    // re-seeding
+    u64 *hashes = (u64*) malloc(sizeof(u64) * cnt);
+    PerfectHash ph = {};
+    for (u64 seed = 0; seed < 4; ++seed) {
+        ph = _PerfectHashInit(cnt, seed);
+        for (u32 i = 0; i < cnt; ++i) {
+            hashes[i] = _PerfectHashKey(keys[i], seed);
+        }
+        if (_PerfectHashPlace(a_dest, &ph, hashes)) {
+            break;
+        }
+        ph.pilots = NULL;
+        if (_PerfectHashHasDuplicate(keys, hashes, cnt)) {
+            break;
+        }
+    }
+    free(hashes);
+    return ph;
+}
+
+u64 PerfectHashSize(PerfectHash *ph) {
+    return sizeof(PerfectHashHdr) + sizeof(u32) * ((u64) ph->nbuckets + ph->table_len - ph->nkeys);
+}
+
+u8 *PerfectHashSerialize(MArena *a_dest, PerfectHash *ph, u64 *size) {
+    // header, pilots and remap table back to back, in host byte order
+    *size = PerfectHashSize(ph);
+    u8 *blob = (u8*) ArenaAllocAligned(a_dest, *size, 8, false);
+
+    PerfectHashHdr hdr = { PH_MAGIC, PH_VERSION, ph->seed, ph->nkeys, ph->nbuckets, ph->table_len, ph->dense_buckets };
+    memcpy(blob, &hdr, sizeof(hdr));
+    memcpy(blob + sizeof(hdr), ph->pilots, sizeof(u32) * ph->nbuckets);
+    memcpy(blob + sizeof(hdr) + sizeof(u32) * ph->nbuckets, ph->remap, sizeof(u32) * (ph->table_len - ph->nkeys));
+    return blob;
+}
+
+PerfectHash PerfectHashLoad(u8 *blob, u64 size) {
+    // no copy, the tables point into the blob, which must stay around and be 4-byte aligned (e.g. mmap'ed);
+    // a truncated, misaligned or foreign blob gives an empty PerfectHash with pilots == NULL
+    PerfectHash ph = {};
+    if (blob == NULL || ((u64) blob & 3) != 0 || size < sizeof(PerfectHashHdr)) {
+        return ph;
+    }
+
+    PerfectHashHdr hdr;
+    memcpy(&hdr, blob, sizeof(hdr));
+    if (hdr.magic != PH_MAGIC || hdr.version != PH_VERSION) {
+        return ph;
+    }
+    if (hdr.nkeys == 0 || hdr.table_len < hdr.nkeys || hdr.dense_buckets == 0 || hdr.dense_buckets >= hdr.nbuckets) {
+        return ph;
+    }
+
+    PerfectHash loaded = {};
+    loaded.seed = hdr.seed;
+    loaded.nkeys = hdr.nkeys;
+    loaded.nbuckets = hdr.nbuckets;
+    loaded.table_len = hdr.table_len;
+    loaded.dense_buckets = hdr.dense_buckets;
+    if (size != PerfectHashSize(&loaded)) {
+        return ph;
+    }
+    loaded.pilots = (u32*) (blob + sizeof(hdr));
+    loaded.remap = loaded.pilots + loaded.nbuckets;
+    return loaded;
+}
+
+
+//
+//  Bloom filter
+//
+//  Split-block Bloom filter: a key maps to one 256-bit block (one cache line at most) and sets one bit in each of
+//  the block's eight 32-bit words, so a query costs one cache miss and a handful of ALU ops (a single AVX2
+//  compare when available). False positive rate is ~3% at 8 bits/key, ~0.5% at 12 and ~0.15% at 16.
+//  Put it in front of MapGet or file lookups and skip those whenever BloomMayContain() says no.
+
+
+#define BLOOM_BLOCK_WORDS 8
+
+struct BloomFilter {
+    u32 *blocks;
+    u32 nblocks;
+};
+
+static const u32 g_bloom_salt[BLOOM_BLOCK_WORDS] = {
+    0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU,
+    0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U
+};
+
+BloomFilter InitBloomFilter(MArena *a_dest, u32 expected_keys, u32 bits_per_key = 10) {
+    // always at least one block, so lookups never index an empty array
+    assert(bits_per_key > 0);
+
+    BloomFilter filter = {};
+    u64 nbits = (u64) MaxU32(expected_keys, 1) * bits_per_key;
+    filter.nblocks = (u32) MaxU64((nbits + 255) / 256, 1);
+    filter.blocks = (u32*) ArenaAllocAligned(a_dest, sizeof(u32) * BLOOM_BLOCK_WORDS * filter.nblocks, CACHE_LINE_SIZE);
+    return filter;
+}
+
+void BloomClear(BloomFilter *filter) {
+    memset(filter->blocks, 0, sizeof(u32) * BLOOM_BLOCK_WORDS * filter->nblocks);
+}
+
+inline
+u32 *_BloomBlock(BloomFilter *filter, u64 hash) {
+    // multiply-shift range reduction on the high half, the low half picks the bits
+    u32 idx = (u32) (((hash >> 32) * filter->nblocks) >> 32);
+    return filter->blocks + idx * BLOOM_BLOCK_WORDS;
+}
+
+void BloomAdd(BloomFilter *filter, u64 key) {
+    u64 hash = Hash64(key);
+    u32 *block = _BloomBlock(filter, hash);
+    u32 h = (u32) hash;
+
+    #if SIMD_AVX2
+    __m256i salt = _mm256_loadu_si256((__m256i*) g_bloom_salt);
+    __m256i bits = _mm256_srli_epi32(_mm256_mullo_epi32(_mm256_set1_epi32(h), salt), 27);
+    __m256i mask = _mm256_sllv_epi32(_mm256_set1_epi32(1), bits);
+    __m256i blk = _mm256_load_si256((__m256i*) block);
+    _mm256_store_si256((__m256i*) block, _mm256_or_si256(blk, mask));
+    #else
+    for (u32 i = 0; i < BLOOM_BLOCK_WORDS; ++i) {
+        block[i] |= 1u << ((h * g_bloom_salt[i]) >> 27);
+    }
+    #endif
+}
+
+bool BloomMayContain(BloomFilter *filter, u64 key) {
+    u64 hash = Hash64(key);
+    u32 *block = _BloomBlock(filter, hash);
+    u32 h = (u32) hash;
+
+    #if SIMD_AVX2
+    __m256i salt = _mm256_loadu_si256((__m256i*) g_bloom_salt);
+    __m256i bits = _mm256_srli_epi32(_mm256_mullo_epi32(_mm256_set1_epi32(h), salt), 27);
+    __m256i mask = _mm256_sllv_epi32(_mm256_set1_epi32(1), bits);
+    __m256i blk = _mm256_load_si256((__m256i*) block);
+    return _mm256_testc_si256(blk, mask) != 0;
+    #else
+    u32 miss = 0;
+    for (u32 i = 0; i < BLOOM_BLOCK_WORDS; ++i) {
+        u32 mask = 1u << ((h * g_bloom_salt[i]) >> 27);
+        miss |= (block[i] & mask) ^ mask;
+    }
+    return miss == 0;
+    #endif
+}
+
+// wrappers
+inline
+void BloomAdd(BloomFilter *filter, Str skey) {
+    BloomAdd(filter, HashStringValue(skey));
+}
+inline
+bool BloomMayContain(BloomFilter *filter, Str skey) {
+    return BloomMayContain(filter, HashStringValue(skey));
+}
+
+
+//
+//  Cuckoo filter
+//
+//  Approximate set membership with deletion. Buckets hold four 16-bit fingerprints (zero marks an empty entry)
+//  and each key has two candidate buckets, the second derived from the first and the fingerprint alone, so
+//  entries can be relocated without knowing their keys. Lookups test both buckets with SWAR compares. Around
+//  0.01% false positives; inserts start failing around 95% load. Only delete keys that were added.
+
+
+#define CUCKOO_BUCKET_SIZE 4
+#define CUCKOO_MAX_KICKS 500
+
+struct CuckooFilter {
+    u64 *buckets; // four u16 fingerprints per bucket
+    u32 nbuckets; // power of two
+    u32 mask;
+    u32 len;
+    u64 kick_state;
+};
+
+CuckooFilter InitCuckooFilter(MArena *a_dest, u32 expected_keys) {
+    CuckooFilter filter = {};
+    u32 need = MaxU32((u32) (expected_keys / (0.9f * CUCKOO_BUCKET_SIZE)) + 1, 2);
+    filter.nbuckets = 2;
+    while (filter.nbuckets < need) {
+        filter.nbuckets *= 2;
+    }
+    filter.mask = filter.nbuckets - 1;
+    filter.buckets = (u64*) ArenaAllocAligned(a_dest, sizeof(u64) * filter.nbuckets, CACHE_LINE_SIZE);
+    filter.kick_state = 0x9e3779b97f4a7c15ULL;
+    return filter;
+}
+
+inline
+void _CuckooIndexes(CuckooFilter *filter, u64 key, u32 *idx1, u16 *fp) {
+    u64 hash = Hash64(key);
+    *fp = (u16) (hash >> 48);
+    if (*fp == 0) {
+        *fp = 1;
+    }
+    *idx1 = (u32) hash & filter->mask;
+}
+
+inline
+u32 _CuckooAltIndex(CuckooFilter *filter, u32 idx, u16 fp) {
+    return (idx ^ (u32) Hash64(fp)) & filter->mask;
+}
+
+inline
+bool _CuckooBucketHas(u64 bucket, u16 fp) {
+    // SWAR: is any 16-bit lane of bucket equal to fp
+    u64 x = bucket ^ (0x0001000100010001ULL * fp);
+    return ((x - 0x0001000100010001ULL) & ~x & 0x8000800080008000ULL) != 0;
+}
+
+inline
+bool _CuckooBucketInsert(u64 *bucket, u16 fp) {
+    for (u32 i = 0; i < CUCKOO_BUCKET_SIZE; ++i) {
+        u64 lane = (*bucket >> (16 * i)) & 0xFFFF;
+        if (lane == 0) {
+            *bucket |= (u64) fp << (16 * i);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool CuckooAdd(CuckooFilter *filter, u64 key) {
+    // returns false when the filter is too full, the key is then not added
+    u32 i1;
+    u16 fp;
+    _CuckooIndexes(filter, key, &i1, &fp);
+    u32 i2 = _CuckooAltIndex(filter, i1, fp);
+
+    if (_CuckooBucketInsert(filter->buckets + i1, fp) || _CuckooBucketInsert(filter->buckets + i2, fp)) {
+        filter->len++;
+        return true;
+    }
+
+    // relocate: swap fp with a random victim and move the victim to its alternate bucket
+    u32 idx = (filter->kick_state & 1) ? i1 : i2;
+    u64 *trail_bucket[CUCKOO_MAX_KICKS];
+    u32 trail_lane[CUCKOO_MAX_KICKS];
+    for (u32 kick = 0; kick < CUCKOO_MAX_KICKS; ++kick) {
+        filter->kick_state = Hash64(filter->kick_state);
+        u32 lane = (u32) (filter->kick_state >> 62);
+        u64 *bucket = filter->buckets + idx;
+
+        u16 victim = (u16) (*bucket >> (16 * lane));
+        *bucket = (*bucket & ~(0xFFFFULL << (16 * lane))) | ((u64) fp << (16 * lane));
+        trail_bucket[kick] = bucket;
+        trail_lane[kick] = lane;
+
+        fp = victim;
+        idx = _CuckooAltIndex(filter, idx, fp);
+        if (_CuckooBucketInsert(filter->buckets + idx, fp)) {
+            filter->len++;
+            return true;
+        }
+    }
+
+    // undo the kicks so that no previously added key is lost
+    for (s32 kick = CUCKOO_MAX_KICKS - 1; kick >= 0; --kick) {
+        u64 *bucket = trail_bucket[kick];
+        u32 lane = trail_lane[kick];
+        u16 displaced = (u16) (*bucket >> (16 * lane));
+        *bucket = (*bucket & ~(0xFFFFULL << (16 * lane))) | ((u64) fp << (16 * lane));
+        fp = displaced;
+    }
+    return false;
+}
+
+bool CuckooMayContain(CuckooFilter *filter, u64 key) {
+    u32 i1;
+    u16 fp;
+    _CuckooIndexes(filter, key, &i1, &fp);
+    u32 i2 = _CuckooAltIndex(filter, i1, fp);
+    return _CuckooBucketHas(filter->buckets[i1], fp) | _CuckooBucketHas(filter->buckets[i2], fp);
+}
+
+bool CuckooRemove(CuckooFilter *filter, u64 key) {
+    u32 i1;
+    u16 fp;
+    _CuckooIndexes(filter, key, &i1, &fp);
+    u32 idxs[2] = { i1, _CuckooAltIndex(filter, i1, fp) };
+    for (u32 b = 0; b < 2; ++b) {
+        u64 *bucket = filter->buckets + idxs[b];
+        for (u32 i = 0; i < CUCKOO_BUCKET_SIZE; ++i) {
+            if (((*bucket >> (16 * i)) & 0xFFFF) == fp) {
+                *bucket &= ~(0xFFFFULL << (16 * i));
+                filter->len--;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+// wrappers
+inline
+bool CuckooAdd(CuckooFilter *filter, Str skey) {
+    return CuckooAdd(filter, HashStringValue(skey));
+}
+inline
+bool CuckooMayContain(CuckooFilter *filter, Str skey) {
+    return CuckooMayContain(filter, HashStringValue(skey));
+}
+inline
+bool CuckooRemove(CuckooFilter *filter, Str skey) {
+    return CuckooRemove(filter, HashStringValue(skey));
+}
+
+
+//
+//  LRU cache
+//
+//  Maps u64 keys (or hashed strings) to void* values and evicts the least recently used entry once the entry
+//  or byte budget is exceeded. Entries are pool-allocated LList2 nodes on a circular recency list with the
+//  sentinel in the cache, most recent first, and are located through a HashMap from key to entry.
+//  The cache holds self-pointers, so it is allocated on the arena and handed out by pointer.
+
+
+struct LRUEntry {
+    LList2 node; // must be the first member
+    u64 key;
+    void *val;
+    u64 size;
+};
+
+typedef void (*LRUEvictFunc)(u64 key, void *val, void *userdata);
+
+struct LRUCache {
+    HashMap map;
+    MPool pool;
+    LList2 recent; // sentinel: recent.next is the most, recent.prev the least recently used
+    u32 len;
+    u32 max_entries;
+    u64 bytes;
+    u64 max_bytes; // 0: no byte budget
+
+    LRUEvictFunc on_evict;
+    void *on_evict_userdata;
+
+    u64 hits;
+    u64 misses;
+    u64 evictions;
+
+    void Print() {
+        printf("entries: %u/%u, bytes: %lu/%lu, hits: %lu, misses: %lu, evictions: %lu\n", len, max_entries, bytes, max_bytes, hits, misses, evictions);
+    }
+};
+
+LRUCache *InitLRUCache(MArena *a_dest, u32 max_entries, u64 max_bytes = 0, LRUEvictFunc on_evict = NULL, void *on_evict_userdata = NULL) {
+    assert(max_entries > 0);
+
+    LRUCache *cache = (LRUCache*) ArenaAlloc(a_dest, sizeof(LRUCache));
+    cache->map = InitMap(a_dest, 2 * max_entries + 1);
+    cache->pool = PoolCreate(a_dest, sizeof(LRUEntry), max_entries + 1);
+    cache->recent.next = &cache->recent;
+    cache->recent.prev = &cache->recent;
+    cache->max_entries = max_entries;
+    cache->max_bytes = max_bytes;
+    cache->on_evict = on_evict;
+    cache->on_evict_userdata = on_evict_userdata;
+    return cache;
+}
+
+void _LRURemoveEntry(LRUCache *cache, LRUEntry *entry) {
+    MapRemove(&cache->map, entry->key);
+    Remove2(entry);
+    cache->bytes -= entry->size;
+    cache->len--;
+    PoolFree(&cache->pool, entry);
+}
+
+void LRUEvict(LRUCache *cache) {
+    LList2 *last = cache->recent.prev;
+    if (last == &cache->recent) {
+        return;
+    }
+    LRUEntry *entry = (LRUEntry*) last;
+    if (cache->on_evict) {
+        cache->on_evict(entry->key, entry->val, cache->on_evict_userdata);
+    }
+    _LRURemoveEntry(cache, entry);
+    cache->evictions++;
+}
+
+void *LRUGet(LRUCache *cache, u64 key) {
+    LRUEntry *entry = (LRUEntry*) MapGet(&cache->map, key);
+    if (entry == NULL) {
+        cache->misses++;
+        return NULL;
+    }
+    cache->hits++;
+
+    // move to front
+    if (cache->recent.next != &entry->node) {
+        Remove2(entry);
+        InsertBefore2(entry, cache->recent.next);
+    }
+    return entry->val;
+}
+
+void LRUPut(LRUCache *cache, u64 key, void *val, u64 size = 0) {
+    assert(key != 0);
+    assert((cache->max_bytes == 0 || size <= cache->max_bytes) && "entry exceeds the byte budget");
+
+    LRUEntry *entry = (LRUEntry*) MapGet(&cache->map, key);
+    if (entry) {
+        // update in place
+        Remove2(entry);
+        cache->bytes -= entry->size;
+    }
+    else {
+        if (cache->len == cache->max_entries) {
+            LRUEvict(cache);
+        }
+        entry = (LRUEntry*) PoolAlloc(&cache->pool);
+        assert(entry != NULL);
+        entry->key = key;
+        MapPut(&cache->map, key, entry);
+        cache->len++;
+    }
+    entry->val = val;
+    entry->size = size;
+    cache->bytes += size;
+    InsertBefore2(entry, cache->recent.next);
+
+    // the new entry is at the front and is never evicted here, it fits by the assert above
+    while (cache->max_bytes && cache->bytes > cache->max_bytes) {
+        LRUEvict(cache);
+    }
+}
+
+bool LRURemove(LRUCache *cache, u64 key) {
+    LRUEntry *entry = (LRUEntry*) MapGet(&cache->map, key);
+    if (entry == NULL) {
+        return false;
+    }
+    _LRURemoveEntry(cache, entry);
+    return true;
+}
+
+// wrappers
+inline
+void *LRUGet(LRUCache *cache, Str skey) {
+    return LRUGet(cache, HashStringValue(skey));
+}
+inline
+void LRUPut(LRUCache *cache, Str skey, void *val, u64 size = 0) {
+    LRUPut(cache, HashStringValue(skey), val, size);
+}
+inline
+bool LRURemove(LRUCache *cache, Str skey) {
+    return LRURemove(cache, HashStringValue(skey));
+}
+
+
+//
+// random
+//
+//  The Rand* helpers draw from a RandState, a xoshiro256++ generator (Blackman & Vigna, public domain, see
+//  https://prng.di.unimi.it): 256 bits of state, period 2^256 - 1. Each thread has its own default state,
+//  g_randstate, used by the helpers that take no state; RandInit seeds the calling thread's. For parallel runs
+//  that must be reproducible, give worker i its own RandStream(seed, i): streams start 2^128 draws apart, so
+//  they never overlap, and what a worker draws does not depend on how the threads are scheduled.
+//  The KISS generator below is kept for existing callers of Kiss_Random; it is not thread-safe.
+/*
+    RandState streams[8];
+    RandStreams(seed, streams, 8);
+    // worker i:
+    f64 x = Rand01(&streams[i]);
+*/
+
+
+#ifndef ULONG_MAX
+#  define ULONG_MAX ( (u64) 0xffffffffffffffffUL )
+#endif
+
+void Kiss_SRandom(u64 state[7], u64 seed) {
+    if (seed == 0) seed = 1;
+    state[0] = seed | 1; // x
+    state[1] = seed | 2; // y
+    state[2] = seed | 4; // z
+    state[3] = seed | 8; // w
+    state[4] = 0;        // carry
+}
+u64 Kiss_Random(u64 state[7]) {
+    state[0] = state[0] * 69069 + 1;
+    state[1] ^= state[1] << 13;
+    state[1] ^= state[1] >> 17;
+    state[1] ^= state[1] << 5;
+    state[5] = (state[2] >> 2) + (state[3] >> 3) + (state[4] >> 2);
+    state[6] = state[3] + state[3] + state[2] + state[4];
+    state[2] = state[3];
+    state[3] = state[6];
+    state[4] = state[5] >> 30;
+    return state[0] + state[1] + state[3];
+}
+u64 g_kiss_randstate[7];
+
+struct RandState {
+    u64 s[4];
+};
+
+inline
+u64 _RotlU64(u64 x, u32 k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+inline
+u64 RandNext(RandState *r) {
+    u64 *s = r->s;
+    u64 result = _RotlU64(s[0] + s[3], 23) + s[0];
+    u64 t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = _RotlU64(s[3], 45);
+    return result;
+}
+
+RandState InitRandState(u64 seed) {
+    // the state words are splitmix64 outputs, never all zero
+    RandState r;
+    for (u32 i = 0; i < 4; ++i) {
+        seed += 0x9E3779B97F4A7C15ull;
+        r.s[i] = Hash64(seed);
+    }
+    return r;
+}
+
+void _RandJump(RandState *r, const u64 poly[4]) {
+    u64 acc[4] = {};
+    for (u32 i = 0; i < 4; ++i) {
+        for (u32 b = 0; b < 64; ++b) {
+            if (poly[i] & (1ull << b)) {
+                acc[0] ^= r->s[0];
+                acc[1] ^= r->s[1];
+                acc[2] ^= r->s[2];
+                acc[3] ^= r->s[3];
+            }
+            RandNext(r);
+        }
+    }
+    memcpy(r->s, acc, sizeof(acc));
+}
+
+void RandJump(RandState *r) {
+    // same as 2^128 calls to RandNext
+    static const u64 poly[4] = { 0x180ec6d33cfd0aba, 0xd5a61266f0c9392c, 0xa9582618e03fc9aa, 0x39abdc4529b1661c };
+    _RandJump(r, poly);
+}
+
+void RandLongJump(RandState *r) {
+    // same as 2^192 calls to RandNext, e.g. one long jump per machine and plain jumps per thread
+    static const u64 poly[4] = { 0x76e15d3efefdcbbf, 0xc5004e441c522fb3, 0x77710069854ee241, 0x39109bb02acbe635 };
+    _RandJump(r, poly);
+}
+
+RandState RandSplit(RandState *r) {
+    // hands out r's current stream and moves r on to the next one
+    RandState split = *r;
+    RandJump(r);
+    return split;
+}
+
+void RandStreams(u64 seed, RandState *dest, u32 cnt) {
+    // cnt independent streams from one seed, stream i is the same for any cnt
+    RandState r = InitRandState(seed);
+    for (u32 i = 0; i < cnt; ++i) {
+        dest[i] = RandSplit(&r);
+    }
+}
+
+RandState RandStream(u64 seed, u32 idx) {
+    RandState r = InitRandState(seed);
+    for (u32 i = 0; i < idx; ++i) {
+        RandJump(&r);
+    }
+    return r;
+}
+
+// each thread starts from its own seed, taken from the time and the address of its state
+thread_local RandState g_randstate = InitRandState(ReadSystemTimerMySec() ^ Hash64((u64) &g_randstate));
+
+u32 RandInit(u32 seed = 0) {
+    // seeds the calling thread's default state
+    if (seed == 0) {
+        seed = (u32) Hash(ReadSystemTimerMySec());
+    }
+    g_randstate = InitRandState(seed);
+    Kiss_SRandom(g_kiss_randstate, seed);
+    Kiss_Random(g_kiss_randstate); // flush the first one
+
+    return seed;
+}
+
+// on any generator with a RandNext() overload, e.g. RandState or Philox
+template<typename R>
+u64 RandMinMax64(R *r, u64 min, u64 max) {
+    assert(max > min);
+    return RandNext(r) % (max - min + 1) + min;
+}
+template<typename R>
+f64 Rand01(R *r) {
+    f64 randnum = (f64) RandNext(r);
+    randnum /= (f64) ULONG_MAX + 1;
+    return randnum;
+}
+template<typename R>
+f32 Rand01_f32(R *r) {
+    f32 randnum = (f32) RandNext(r);
+    randnum /= (f32) ULONG_MAX + 1;
+    return randnum;
+}
+template<typename R>
+f32 RandPM1_f32(R *r) {
+    f32 randnum = (f32) RandNext(r);
+    randnum /= ((f32) ULONG_MAX + 1) / 2;
+    randnum -= 1;
+    return randnum;
+}
+template<typename R>
+int RandMinMaxI(R *r, int min, int max) {
+    assert(max > min);
+    return RandNext(r) % (max - min + 1) + min;
+}
+template<typename R>
+u32 RandMinMaxU(R *r, u32 min, u32 max) {
+    assert(max > min);
+    return RandNext(r) % (max - min + 1) + min;
+}
+template<typename R>
+f32 RandMinMaxI_f32(R *r, int min, int max) {
+    assert(max > min);
+    return (f32) (RandNext(r) % (max - min + 1) + min);
+}
+template<typename R>
+int RandDice(R *r, u32 max) {
+    assert(max > 0);
+    return RandNext(r) % max + 1;
+}
+template<typename R>
+int RandIntMax(R *r, u32 max) {
+    assert(max > 0);
+    return RandNext(r) % max + 1;
+}
+
+// on the calling thread's default state
+inline u64 RandMinMax64(u64 min, u64 max) { return RandMinMax64(&g_randstate, min, max); }
+inline f64 Rand01() { return Rand01(&g_randstate); }
+inline f32 Rand01_f32() { return Rand01_f32(&g_randstate); }
+inline f32 RandPM1_f32() { return RandPM1_f32(&g_randstate); }
+inline int RandMinMaxI(int min, int max) { return RandMinMaxI(&g_randstate, min, max); }
+inline u32 RandMinMaxU(u32 min, u32 max) { return RandMinMaxU(&g_randstate, min, max); }
+inline u32 RandMinU16(u32 min) { return RandMinMaxU(&g_randstate, min, (u16) -1); }
+inline f32 RandMinMaxI_f32(int min, int max) { return RandMinMaxI_f32(&g_randstate, min, max); }
+inline int RandDice(u32 max) { return RandDice(&g_randstate, max); }
+inline int RandIntMax(u32 max) { return RandIntMax(&g_randstate, max); }
+
+
+//
+//  Batch random numbers
+//
+//  RAND_LANES xoshiro256++ generators run side by side, in two AVX2 vectors of four u64 lanes when built with
+//  -mavx2 and in a plain loop over the same lanes otherwise, so a seeded batch writes the same numbers on every
+//  build. The lanes are consecutive RandSplit streams. Floats in [0, 1) put 23 random bits below the exponent of
+//  1.0f and subtract 1, and bounded integers take the high half of a 32x32-bit multiply (Lemire), with no
+//  division; that leaves a bias of at most range / 2^32, which is negligible unless the range is huge.
+/*
+    RandBatch rb = InitRandBatch(&g_randstate);
+    f32 *xs = (f32*) ArenaAlloc(a, sizeof(f32) * cnt, false);
+    RandFillF32(&rb, xs, cnt);
+*/
+
+
+#define RAND_LANES 8
+
+struct RandBatch {
+    alignas(32) u64 s[4][RAND_LANES];   // state word, lane
+};
+
+RandBatch InitRandBatch(RandState *r) {
+    // takes RAND_LANES streams from r, which moves on past them
+    RandBatch rb;
+    for (u32 lane = 0; lane < RAND_LANES; ++lane) {
+        RandState split = RandSplit(r);
+        for (u32 w = 0; w < 4; ++w) {
+            rb.s[w][lane] = split.s[w];
+        }
+    }
+    return rb;
+}
+
+#if SIMD_AVX2
+inline
+__m256i _RandRotl256(__m256i x, s32 k) {
+    return _mm256_or_si256(_mm256_slli_epi64(x, k), _mm256_srli_epi64(x, 64 - k));
+}
+
+inline
+__m256i _RandNext256(__m256i *s0, __m256i *s1, __m256i *s2, __m256i *s3) {
+    __m256i result = _mm256_add_epi64(_RandRotl256(_mm256_add_epi64(*s0, *s3), 23), *s0);
+    __m256i t = _mm256_slli_epi64(*s1, 17);
+    *s2 = _mm256_xor_si256(*s2, *s0);
+    *s3 = _mm256_xor_si256(*s3, *s1);
+    *s1 = _mm256_xor_si256(*s1, *s2);
+    *s0 = _mm256_xor_si256(*s0, *s3);
+    *s2 = _mm256_xor_si256(*s2, t);
+    *s3 = _RandRotl256(*s3, 45);
+    return result;
+}
+#endif
+
+void _RandBlocksU64(RandBatch *rb, u64 *dest, u64 nblocks) {
+    // nblocks * RAND_LANES raw outputs, lane-interleaved
+#if SIMD_AVX2
+    __m256i a0 = _mm256_load_si256((__m256i*) rb->s[0]);
+    __m256i a1 = _mm256_load_si256((__m256i*) rb->s[1]);
+    __m256i a2 = _mm256_load_si256((__m256i*) rb->s[2]);
+    __m256i a3 = _mm256_load_si256((__m256i*) rb->s[3]);
+    __m256i b0 = _mm256_load_si256((__m256i*) (rb->s[0] + 4));
+    __m256i b1 = _mm256_load_si256((__m256i*) (rb->s[1] + 4));
+    __m256i b2 = _mm256_load_si256((__m256i*) (rb->s[2] + 4));
+    __m256i b3 = _mm256_load_si256((__m256i*) (rb->s[3] + 4));
+    for (u64 i = 0; i < nblocks; ++i) {
+        _mm256_storeu_si256((__m256i*) (dest + i * RAND_LANES), _RandNext256(&a0, &a1, &a2, &a3));
+        _mm256_storeu_si256((__m256i*) (dest + i * RAND_LANES + 4), _RandNext256(&b0, &b1, &b2, &b3));
+    }
+    _mm256_store_si256((__m256i*) rb->s[0], a0);
+    _mm256_store_si256((__m256i*) rb->s[1], a1);
+    _mm256_store_si256((__m256i*) rb->s[2], a2);
+    _mm256_store_si256((__m256i*) rb->s[3], a3);
+    _mm256_store_si256((__m256i*) (rb->s[0] + 4), b0);
+    _mm256_store_si256((__m256i*) (rb->s[1] + 4), b1);
+    _mm256_store_si256((__m256i*) (rb->s[2] + 4), b2);
+    _mm256_store_si256((__m256i*) (rb->s[3] + 4), b3);
+#else
+    // local copies, so the compiler need not assume that dest aliases the state
+    u64 s0[RAND_LANES];
+    u64 s1[RAND_LANES];
+    u64 s2[RAND_LANES];
+    u64 s3[RAND_LANES];
+    memcpy(s0, rb->s[0], sizeof(s0));
+    memcpy(s1, rb->s[1], sizeof(s1));
+    memcpy(s2, rb->s[2], sizeof(s2));
+    memcpy(s3, rb->s[3], sizeof(s3));
+    for (u64 i = 0; i < nblocks; ++i) {
+        for (u32 l = 0; l < RAND_LANES; ++l) {
+            dest[i * RAND_LANES + l] = _RotlU64(s0[l] + s3[l], 23) + s0[l];
+            u64 t = s1[l] << 17;
+            s2[l] ^= s0[l];
+            s3[l] ^= s1[l];
+            s1[l] ^= s2[l];
+            s0[l] ^= s3[l];
+            s2[l] ^= t;
+            s3[l] = _RotlU64(s3[l], 45);
+        }
+    }
+    memcpy(rb->s[0], s0, sizeof(s0));
+    memcpy(rb->s[1], s1, sizeof(s1));
+    memcpy(rb->s[2], s2, sizeof(s2));
+    memcpy(rb->s[3], s3, sizeof(s3));
+#endif
+}
+
+#define RAND_CHUNK 256  // u64s generated per round of the float and range fills
+
+void RandFillU64(RandBatch *rb, u64 *dest, u64 cnt) {
+    // a partial last block is drawn in full, its extra values are dropped
+    u64 nblocks = cnt / RAND_LANES;
+    _RandBlocksU64(rb, dest, nblocks);
+    if (cnt % RAND_LANES) {
+        u64 tail[RAND_LANES];
+        _RandBlocksU64(rb, tail, 1);
+        memcpy(dest + nblocks * RAND_LANES, tail, sizeof(u64) * (cnt % RAND_LANES));
+    }
+}
+
+inline
+f32 _RandF32(u32 bits) {
+    u32 one_to_two = (bits >> 9) | 0x3F800000;
+    f32 x;
+    memcpy(&x, &one_to_two, sizeof(x));
+    return x - 1.0f;
+}
+
+void RandFillF32(RandBatch *rb, f32 *dest, u64 cnt) {
+    // uniform in [0, 1), two floats per u64
+    u64 raw[RAND_CHUNK];
+    for (u64 at = 0; at < cnt; at += 2 * RAND_CHUNK) {
+        u32 n = (u32) MinU64(2 * RAND_CHUNK, cnt - at);
+        _RandBlocksU64(rb, raw, ((n + 1) / 2 + RAND_LANES - 1) / RAND_LANES);
+        f32 *out = dest + at;
+        for (u32 i = 0; i < n / 2; ++i) {
+            out[2 * i] = _RandF32((u32) raw[i]);
+            out[2 * i + 1] = _RandF32((u32) (raw[i] >> 32));
+        }
+        if (n & 1) {
+            out[n - 1] = _RandF32((u32) raw[n / 2]);
+        }
+    }
+}
+
+void RandFillF64(RandBatch *rb, f64 *dest, u64 cnt) {
+    // uniform in [0, 1), 52 random bits each
+    u64 raw[RAND_CHUNK];
+    for (u64 at = 0; at < cnt; at += RAND_CHUNK) {
+        u32 n = (u32) MinU64(RAND_CHUNK, cnt - at);
+        _RandBlocksU64(rb, raw, (n + RAND_LANES - 1) / RAND_LANES);
+        for (u32 i = 0; i < n; ++i) {
+            u64 one_to_two = (raw[i] >> 12) | 0x3FF0000000000000ull;
+            f64 x;
+            memcpy(&x, &one_to_two, sizeof(x));
+            dest[at + i] = x - 1.0;
+        }
+    }
+}
+
+void RandFillRange(RandBatch *rb, u32 *dest, u64 cnt, u32 min, u32 max) {
+    // uniform in [min, max], two values per u64
+    assert(max > min);
+
+    u64 range = (u64) max - min + 1;
+    u64 raw[RAND_CHUNK];
+    for (u64 at = 0; at < cnt; at += 2 * RAND_CHUNK) {
+        u32 n = (u32) MinU64(2 * RAND_CHUNK, cnt - at);
+        _RandBlocksU64(rb, raw, ((n + 1) / 2 + RAND_LANES - 1) / RAND_LANES);
+        u32 *out = dest + at;
+        for (u32 i = 0; i < n / 2; ++i) {
+            out[2 * i] = min + (u32) (((raw[i] & 0xFFFFFFFF) * range) >> 32);
+            out[2 * i + 1] = min + (u32) (((raw[i] >> 32) * range) >> 32);
+        }
+        if (n & 1) {
+            out[n - 1] = min + (u32) (((raw[n / 2] & 0xFFFFFFFF) * range) >> 32);
+        }
+    }
+}
+
+
+//
+//  Counter-based random numbers (Philox4x32-10)
+//
+//  Philox (Salmon et al., "Parallel random numbers: as easy as 1, 2, 3", SC 2011) turns a 128-bit counter and a
+//  64-bit key into four random u32 by ten rounds of multiply and xor. Output depends on (seed, counter) only,
+//  so any element of a parallel loop can draw its own numbers from InitPhilox(seed, element) without shared
+//  state, and gets the same numbers on any thread, in any order. Counter words 0-1 count blocks within a stream,
+//  words 2-3 hold the stream id. A Philox works with the Rand* helpers; PhiloxFillU32 / PhiloxFillF32 compute
+//  eight blocks per step with AVX2 and write element i of the fill from word i % 4 of block i / 4.
+/*
+    for (u32 i = 0; i < cnt; ++i) {     // any thread, any order
+        Philox p = InitPhilox(seed, i);
+        f64 x = Rand01(&p);
+    }
+*/
+
+
+#define PHILOX_M0 0xD2511F53
+#define PHILOX_M1 0xCD9E8D57
+#define PHILOX_W0 0x9E3779B9
+#define PHILOX_W1 0xBB67AE85
+
+struct Philox {
+    u32 key[2];
+    u32 ctr[4];
+    u32 buf[4];
+    u32 pos;    // next unused word in buf, 4 when empty
+};
+
+void PhiloxBlock(const u32 ctr[4], const u32 key[2], u32 out[4]) {
+    u32 c0 = ctr[0];
+    u32 c1 = ctr[1];
+    u32 c2 = ctr[2];
+    u32 c3 = ctr[3];
+    u32 k0 = key[0];
+    u32 k1 = key[1];
+    for (u32 round = 0; round < 10; ++round) {
+        u64 p0 = (u64) PHILOX_M0 * c0;
+        u64 p1 = (u64) PHILOX_M1 * c2;
+        c0 = (u32) (p1 >> 32) ^ c1 ^ k0;
+        c1 = (u32) p1;
+        c2 = (u32) (p0 >> 32) ^ c3 ^ k1;
+        c3 = (u32) p0;
+        k0 += PHILOX_W0;
+        k1 += PHILOX_W1;
+    }
+    out[0] = c0;
+    out[1] = c1;
+    out[2] = c2;
+    out[3] = c3;
+}
+
+Philox InitPhilox(u64 seed, u64 stream = 0, u64 block = 0) {
+    Philox p = {};
+    p.key[0] = (u32) seed;
+    p.key[1] = (u32) (seed >> 32);
+    p.ctr[0] = (u32) block;
+    p.ctr[1] = (u32) (block >> 32);
+    p.ctr[2] = (u32) stream;
+    p.ctr[3] = (u32) (stream >> 32);
+    p.pos = 4;
+    return p;
+}
+
+inline
+void _PhiloxAdvance(Philox *p, u64 nblocks) {
+    u64 block = ((u64) p->ctr[1] << 32 | p->ctr[0]) + nblocks;
+    p->ctr[0] = (u32) block;
+    p->ctr[1] = (u32) (block >> 32);
+}
+
+inline
+u32 PhiloxNext32(Philox *p) {
+    if (p->pos == 4) {
+        PhiloxBlock(p->ctr, p->key, p->buf);
+        _PhiloxAdvance(p, 1);
+        p->pos = 0;
+    }
+    return p->buf[p->pos++];
+}
+
+inline
+u64 RandNext(Philox *p) {
+    u64 lo = PhiloxNext32(p);
+    return lo | (u64) PhiloxNext32(p) << 32;
+}
+
+#if SIMD_AVX2
+inline
+void _PhiloxMulHiLo256(__m256i a, u32 m, __m256i *hi, __m256i *lo) {
+    __m256i mv = _mm256_set1_epi64x(m);
+    __m256i even = _mm256_mul_epu32(a, mv);
+    __m256i odd = _mm256_mul_epu32(_mm256_srli_epi64(a, 32), mv);
+    *lo = _mm256_blend_epi32(even, _mm256_slli_epi64(odd, 32), 0xAA);
+    *hi = _mm256_blend_epi32(_mm256_srli_epi64(even, 32), odd, 0xAA);
+}
+
+void _PhiloxBlocks8(Philox *p, u32 *dest) {
+    // eight consecutive blocks, written in block order
+    u64 block = (u64) p->ctr[1] << 32 | p->ctr[0];
+    __m256i c0 = _mm256_setr_epi32((s32) (u32) block, (s32) (u32) (block + 1), (s32) (u32) (block + 2),
+        (s32) (u32) (block + 3), (s32) (u32) (block + 4), (s32) (u32) (block + 5), (s32) (u32) (block + 6),
+        (s32) (u32) (block + 7));
+    __m256i c1 = _mm256_setr_epi32((s32) (u32) (block >> 32), (s32) (u32) ((block + 1) >> 32),
+        (s32) (u32) ((block + 2) >> 32), (s32) (u32) ((block + 3) >> 32), (s32) (u32) ((block + 4) >> 32),
+        (s32) (u32) ((block + 5) >> 32), (s32) (u32) ((block + 6) >> 32), (s32) (u32) ((block + 7) >> 32));
+    __m256i c2 = _mm256_set1_epi32((s32) p->ctr[2]);
+    __m256i c3 = _mm256_set1_epi32((s32) p->ctr[3]);
+    u32 k0 = p->key[0];
+    u32 k1 = p->key[1];
+    for (u32 round = 0; round < 10; ++round) {
+        __m256i hi0, lo0, hi1, lo1;
+        _PhiloxMulHiLo256(c0, PHILOX_M0, &hi0, &lo0);
+        _PhiloxMulHiLo256(c2, PHILOX_M1, &hi1, &lo1);
+        c0 = _mm256_xor_si256(_mm256_xor_si256(hi1, c1), _mm256_set1_epi32((s32) k0));
+        c1 = lo1;
+        c2 = _mm256_xor_si256(_mm256_xor_si256(hi0, c3), _mm256_set1_epi32((s32) k1));
+        c3 = lo0;
+        k0 += PHILOX_W0;
+        k1 += PHILOX_W1;
+    }
+
+    // transpose from word-per-vector to block order
+    __m256i t0 = _mm256_unpacklo_epi32(c0, c1);
+    __m256i t1 = _mm256_unpackhi_epi32(c0, c1);
+    __m256i t2 = _mm256_unpacklo_epi32(c2, c3);
+    __m256i t3 = _mm256_unpackhi_epi32(c2, c3);
+    __m256i u0 = _mm256_unpacklo_epi64(t0, t2);
+    __m256i u1 = _mm256_unpackhi_epi64(t0, t2);
+    __m256i u2 = _mm256_unpacklo_epi64(t1, t3);
+    __m256i u3 = _mm256_unpackhi_epi64(t1, t3);
+    _mm256_storeu_si256((__m256i*) dest, _mm256_permute2x128_si256(u0, u1, 0x20));
+    _mm256_storeu_si256((__m256i*) (dest + 8), _mm256_permute2x128_si256(u2, u3, 0x20));
+    _mm256_storeu_si256((__m256i*) (dest + 16), _mm256_permute2x128_si256(u0, u1, 0x31));
+    _mm256_storeu_si256((__m256i*) (dest + 24), _mm256_permute2x128_si256(u2, u3, 0x31));
+    _PhiloxAdvance(p, 8);
+}
+#endif
+
+void PhiloxFillU32(Philox *p, u32 *dest, u64 cnt) {
+    // starts at p's next whole block, words left over from single draws are skipped
+    u64 i = 0;
+#if SIMD_AVX2
+    for (; i + 32 <= cnt; i += 32) {
+        _PhiloxBlocks8(p, dest + i);
+    }
+#endif
+    for (; i + 4 <= cnt; i += 4) {
+        PhiloxBlock(p->ctr, p->key, dest + i);
+        _PhiloxAdvance(p, 1);
+    }
+    if (i < cnt) {
+        u32 out[4];
+        PhiloxBlock(p->ctr, p->key, out);
+        _PhiloxAdvance(p, 1);
+        memcpy(dest + i, out, sizeof(u32) * (cnt - i));
+    }
+    p->pos = 4;
+}
+
+void PhiloxFillF32(Philox *p, f32 *dest, u64 cnt) {
+    // uniform in [0, 1), one float per word
+    u32 raw[2 * RAND_CHUNK];
+    for (u64 at = 0; at < cnt; at += 2 * RAND_CHUNK) {
+        u32 n = (u32) MinU64(2 * RAND_CHUNK, cnt - at);
+        PhiloxFillU32(p, raw, n);
+        for (u32 i = 0; i < n; ++i) {
+            dest[at + i] = _RandF32(raw[i]);
+        }
+    }
+}
+
+
+//
+//  Non-uniform distributions
+//
+//  Normal and exponential values come from Doornik's ziggurat (ZIGNOR): 128 and 256 layers of equal area, where
+//  almost every draw is one random u64, one table load and one multiply, and only the thin wedges and the tail
+//  call exp or log. Discrete weights are sampled in O(1) from a Vose alias table. Shuffle is Fisher-Yates with
+//  Lemire's nearly-divisionless bounded draws. Reservoir keeps a uniform sample of k items from a stream of
+//  unknown length with Li's Algorithm L, which draws how many items to skip rather than a random per item.
+//  All of them take any generator with a RandNext() overload (RandState, Philox), or the thread's default.
+/*
+    f64 x = RandNormal(&r);
+    RandFillNormal(&r, xs, cnt, mean, stddev);
+
+    AliasTable tbl = InitAliasTable(a, weights, nweights);
+    u32 idx = AliasSample(&tbl, &r);
+
+    Shuffle(&r, lst);
+*/
+
+
+#define ZIG_NOR_LAYERS 128
+#define ZIG_NOR_R 3.442619855899
+#define ZIG_NOR_V 9.91256303526217e-3
+#define ZIG_EXP_LAYERS 256
+#define ZIG_EXP_R 7.69711747013104972
+#define ZIG_EXP_V 3.949659822581572e-3
+
+struct ZigTables {
+    f64 nor_x[ZIG_NOR_LAYERS + 1];  // layer edges, nor_x[0] is the base strip's width including the tail
+    f64 nor_ratio[ZIG_NOR_LAYERS];  // nor_x[i + 1] / nor_x[i], below it a draw is inside the layer's core
+    f64 exp_x[ZIG_EXP_LAYERS + 1];
+    f64 exp_ratio[ZIG_EXP_LAYERS];
+};
+
+ZigTables _ZigBuild() {
+    ZigTables t = {};
+
+    f64 f = exp(-0.5 * ZIG_NOR_R * ZIG_NOR_R);
+    t.nor_x[0] = ZIG_NOR_V / f;
+    t.nor_x[1] = ZIG_NOR_R;
+    for (u32 i = 2; i < ZIG_NOR_LAYERS; ++i) {
+        t.nor_x[i] = sqrt(-2 * log(ZIG_NOR_V / t.nor_x[i - 1] + f));
+        f = exp(-0.5 * t.nor_x[i] * t.nor_x[i]);
+    }
+    for (u32 i = 0; i < ZIG_NOR_LAYERS; ++i) {
+        t.nor_ratio[i] = t.nor_x[i + 1] / t.nor_x[i];
+    }
+
+    f = exp(-ZIG_EXP_R);
+    t.exp_x[0] = ZIG_EXP_V / f;
+    t.exp_x[1] = ZIG_EXP_R;
+    for (u32 i = 2; i < ZIG_EXP_LAYERS; ++i) {
+        t.exp_x[i] = -log(ZIG_EXP_V / t.exp_x[i - 1] + f);
+        f = exp(-t.exp_x[i]);
+    }
+    for (u32 i = 0; i < ZIG_EXP_LAYERS; ++i) {
+        t.exp_ratio[i] = t.exp_x[i + 1] / t.exp_x[i];
+    }
+    return t;
+}
+
+ZigTables *ZigGetTables() {
+    // built on first use
+    static ZigTables tables = _ZigBuild();
+    return &tables;
+}
+
+template<typename R>
+f64 _RandOpen01(R *r) {
+    // uniform in (0, 1), safe to take the log of
+    return ((s64) (RandNext(r) >> 11) + 0.5) * (1.0 / 9007199254740992.0);
+}
+
+template<typename R>
+f64 _RandNormal(ZigTables *t, R *r) {
+    while (true) {
+        u64 bits = RandNext(r);
+        u32 i = bits & (ZIG_NOR_LAYERS - 1);
+        f64 u = (s64) (bits >> 11) * (2.0 / 9007199254740992.0) - 1.0;
+        if (fabs(u) < t->nor_ratio[i]) {
+            return u * t->nor_x[i];
+        }
+        if (i == 0) {
+            // tail beyond R (Marsaglia)
+            f64 x;
+            f64 y;
+            do {
+                x = log(_RandOpen01(r)) / ZIG_NOR_R;
+                y = log(_RandOpen01(r));
+            } while (-2 * y < x * x);
+            return (u < 0) ? x - ZIG_NOR_R : ZIG_NOR_R - x;
+        }
+
+        // wedge between the core and the curve
+        f64 x = u * t->nor_x[i];
+        f64 f0 = exp(-0.5 * t->nor_x[i] * t->nor_x[i]);
+        f64 f1 = exp(-0.5 * t->nor_x[i + 1] * t->nor_x[i + 1]);
+        if (f0 + Rand01(r) * (f1 - f0) < exp(-0.5 * x * x)) {
+            return x;
+        }
+    }
+}
+
+template<typename R>
+f64 _RandExp(ZigTables *t, R *r) {
+    while (true) {
+        u64 bits = RandNext(r);
+        u32 i = bits & (ZIG_EXP_LAYERS - 1);
+        f64 u = (s64) (bits >> 11) * (1.0 / 9007199254740992.0);
+        if (u < t->exp_ratio[i]) {
+            return u * t->exp_x[i];
+        }
+        if (i == 0) {
+            // the tail of an exponential is another exponential
+            return ZIG_EXP_R - log(_RandOpen01(r));
+        }
+
+        f64 x = u * t->exp_x[i];
+        f64 f0 = exp(-t->exp_x[i]);
+        f64 f1 = exp(-t->exp_x[i + 1]);
+        if (f0 + Rand01(r) * (f1 - f0) < exp(-x)) {
+            return x;
+        }
+    }
+}
+
+template<typename R>
+f64 RandNormal(R *r, f64 mean = 0, f64 stddev = 1) {
+    return mean + stddev * _RandNormal(ZigGetTables(), r);
+}
+
+template<typename R>
+f64 RandExp(R *r, f64 rate = 1) {
+    return _RandExp(ZigGetTables(), r) / rate;
+}
+
+template<typename R>
+void RandFillNormal(R *r, f64 *dest, u64 cnt, f64 mean = 0, f64 stddev = 1) {
+    ZigTables *t = ZigGetTables();
+    for (u64 i = 0; i < cnt; ++i) {
+        dest[i] = mean + stddev * _RandNormal(t, r);
+    }
+}
+
+template<typename R>
+void RandFillExp(R *r, f64 *dest, u64 cnt, f64 rate = 1) {
+    ZigTables *t = ZigGetTables();
+    f64 scale = 1 / rate;
+    for (u64 i = 0; i < cnt; ++i) {
+        dest[i] = scale * _RandExp(t, r);
+    }
+}
+
+inline f64 RandNormal() { return RandNormal(&g_randstate); }
+inline f64 RandExp() { return RandExp(&g_randstate); }
+
+template<typename R>
+u32 RandBelow(R *r, u32 n) {
+    // uniform in [0, n) without bias, a division only in the rare rejection case (Lemire 2019)
+    assert(n > 0);
+
+    u64 m = (RandNext(r) >> 32) * n;
+    u32 low = (u32) m;
+    if (low < n) {
+        u32 threshold = (0u - n) % n;
+        while (low < threshold) {
+            m = (RandNext(r) >> 32) * n;
+            low = (u32) m;
+        }
+    }
+    return (u32) (m >> 32);
+}
+
+struct AliasSlot {
+    u32 threshold;  // keep the slot's own index when the coin is below, otherwise take alias
+    u32 alias;
+};
+
+struct AliasTable {
+    AliasSlot *slots;
+    u32 len;
+};
+
+AliasTable InitAliasTable(MArena *a_dest, f64 *weights, u32 cnt) {
+    // weights need not sum to 1, but must be non-negative with a positive sum
+    assert(cnt > 0);
+
+    f64 sum = 0;
+    for (u32 i = 0; i < cnt; ++i) {
+        assert(weights[i] >= 0);
+        sum += weights[i];
+    }
+    assert(sum > 0);
+
+    AliasTable tbl = {};
+    tbl.len = cnt;
+    tbl.slots = (AliasSlot*) ArenaAlloc(a_dest, sizeof(AliasSlot) * cnt);
+
+    // Vose: pair each under-full slot with an over-full one, which gives up the difference
+    f64 *scaled = (f64*) malloc(sizeof(f64) * cnt);
+    u32 *small = (u32*) malloc(sizeof(u32) * cnt);
+    u32 *large = (u32*) malloc(sizeof(u32) * cnt);
+    u32 nsmall = 0;
+    u32 nlarge = 0;
+    for (u32 i = 0; i < cnt; ++i) {
+        scaled[i] = weights[i] * cnt / sum;
+        if (scaled[i] < 1) {
+            small[nsmall++] = i;
+        }
+        else {
+            large[nlarge++] = i;
+        }
+    }
+    while (nsmall && nlarge) {
+        u32 s = small[--nsmall];
+        u32 l = large[nlarge - 1];
+        tbl.slots[s] = AliasSlot { (u32) (scaled[s] * 4294967296.0), l };
+        scaled[l] -= 1 - scaled[s];
+        if (scaled[l] < 1) {
+            nlarge--;
+            small[nsmall++] = l;
+        }
+    }
+
+    // the rest are full up to rounding and never take their alias
+    while (nlarge) {
+        u32 l = large[--nlarge];
+        tbl.slots[l] = AliasSlot { 0xFFFFFFFF, l };
+    }
+    while (nsmall) {
+        u32 s = small[--nsmall];
+        tbl.slots[s] = AliasSlot { 0xFFFFFFFF, s };
+    }
+
+    free(large);
+    free(small);
+    free(scaled);
+    return tbl;
+}
+
+AliasTable InitAliasTable(MArena *a_dest, List<f64> weights) {
+    return InitAliasTable(a_dest, weights.lst, weights.len);
+}
+
+template<typename R>
+u32 AliasSample(AliasTable *tbl, R *r) {
+    // index drawn with probability proportional to its weight; one random u64, one slot load
+    u64 bits = RandNext(r);
+    u32 idx = (u32) (((bits & 0xFFFFFFFF) * tbl->len) >> 32);
+    AliasSlot slot = tbl->slots[idx];
+    return ((u32) (bits >> 32) < slot.threshold) ? idx : slot.alias;
+}
+
+template<typename R>
+void AliasSampleBatch(AliasTable *tbl, R *r, u32 *dest, u64 cnt) {
+    for (u64 i = 0; i < cnt; ++i) {
+        dest[i] = AliasSample(tbl, r);
+    }
+}
+
+template<typename T, typename R>
+void Shuffle(R *r, T *lst, u32 len) {
+    // Fisher-Yates, every permutation equally likely
+    for (u32 i = len; i > 1; --i) {
+        u32 j = RandBelow(r, i);
+        T swap = lst[i - 1];
+        lst[i - 1] = lst[j];
+        lst[j] = swap;
+    }
+}
+
+template<typename T, typename R>
+void Shuffle(R *r, List<T> lst) {
+    Shuffle(r, lst.lst, lst.len);
+}
+
+template<typename T>
+void Shuffle(List<T> lst) {
+    Shuffle(&g_randstate, lst.lst, lst.len);
+}
+
+template<typename T>
+struct Reservoir {
+    T *lst;
+    u32 k;
+    u32 len;        // items held, k once the stream is longer than k
+    u64 seen;       // items offered so far
+    u64 next;       // position of the next item to take in
+    f64 w;
+};
+
+template<typename T>
+Reservoir<T> InitReservoir(MArena *a_dest, u32 k) {
+    assert(k > 0);
+
+    Reservoir<T> res = {};
+    res.lst = (T*) ArenaAlloc(a_dest, sizeof(T) * k);
+    res.k = k;
+    return res;
+}
+
+template<typename T, typename R>
+void _ReservoirSkip(Reservoir<T> *res, R *r) {
+    res->w *= exp(log(_RandOpen01(r)) / res->k);
+    res->next += (u64) floor(log(_RandOpen01(r)) / log(1 - res->w)) + 1;
+}
+
+template<typename T, typename R>
+void ReservoirAddBatch(Reservoir<T> *res, R *r, T *items, u64 cnt) {
+    // skipped items cost nothing, after the first k only about k * log(n / k) of n items are looked at
+    u64 i = 0;
+    while (i < cnt && res->len < res->k) {
+        res->lst[res->len++] = items[i++];
+        res->seen++;
+        if (res->len == res->k) {
+            res->w = 1;
+            res->next = res->seen - 1;
+            _ReservoirSkip(res, r);
+        }
+    }
+    while (i < cnt) {
+        u64 end = res->seen + (cnt - i);
+        if (res->next >= end) {
+            res->seen = end;
+            break;
+        }
+        i += res->next - res->seen;
+        res->seen = res->next;
+        res->lst[RandBelow(r, res->k)] = items[i++];
+        res->seen++;
+        _ReservoirSkip(res, r);
+    }
+}
+
+template<typename T, typename R>
+void ReservoirAdd(Reservoir<T> *res, R *r, T item) {
+    ReservoirAddBatch(res, r, &item, 1);
 }
 
 void PrintHex(u8* data, u32 len) {
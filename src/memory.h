@@ -51,12 +51,15 @@ MArena ArenaCreate(u64 fixed_size = 0) {
 }
 
 void ArenaDestroy(MArena *a) {
-    MemoryUnmap(a, a->committed);
+    MemoryUnmap(a->mem, a->mapped);
     *a = {};
 }
 
 inline
 void *ArenaAlloc(MArena *a, u64 len, bool zerod = true) {
+    // freshly committed pages come zeroed from the OS, only the part that was committed before may be dirty
+    u64 dirty = len;
+
     if (a->fixed_size) {
         assert(a->fixed_size == a->committed && "ArenaAlloc: fixed_size misconfigured");
         assert(a->fixed_size >= a->used + len && "ArenaAlloc: fixed_size exceeded");
@@ -68,17 +71,27 @@ void *ArenaAlloc(MArena *a, u64 len, bool zerod = true) {
         u64 amount = ( (len - diff) / ARENA_COMMIT_CHUNK + 1) * ARENA_COMMIT_CHUNK;
         MemoryProtect(a->mem + a->committed, amount );
         a->committed += amount;
+        dirty = diff;
     }
 
     void *result = a->mem + a->used;
     a->used += len;
     if (zerod) {
-        _memzero(result, len);
+        _memzero(result, dirty);
     }
 
     return result;
 }
 
+inline
+void *ArenaAllocAligned(MArena *a, u64 len, u32 align, bool zerod = true) {
+    // align must be a power of two
+    u64 addr = (u64) (a->mem + a->used);
+    u64 pad = (align - (addr & (align - 1))) & (align - 1);
+    ArenaAlloc(a, pad, false);
+    return ArenaAlloc(a, len, zerod);
+}
+
 inline
 void ArenaRelease(MArena *a, u64 len) {
     assert(len <= a->used);
@@ -380,7 +393,7 @@ void ArenaShedTail(MArena *a, List<T> lst, u32 diff_T) {
     assert(a->used >= diff_T * sizeof(T));
     assert(a->mem + a->used == (u8*) (lst.lst + lst.len + diff_T));
 
-    a->mem -= diff_T * sizeof(T);
+    a->used -= diff_T * sizeof(T);
 }
 
 template<class T>
@@ -537,6 +550,181 @@ Stack<T> InitStackStatic(T *mem, u32 cap) {
 }
 
 
+//
+//  Heap / priority queue
+//
+//  d-ary min-heap ordered by operator<, 4-ary by default to keep each set of children within a cache line.
+//  InitHeapIndexed enables DecreaseKey: elements are pushed with a unique id in [0, max_id) and the heap keeps an
+//  id -> position map up to date. Use a max-heap by inverting operator< on T.
+
+
+#define HEAP_NOT_PRESENT 0xFFFFFFFF
+
+
+template<typename T, u32 D = 4>
+struct Heap {
+    T *lst = NULL;
+    u32 *ids = NULL; // heap position -> id (indexed heaps only)
+    u32 *pos = NULL; // id -> heap position (indexed heaps only)
+    u32 len = 0;
+    u32 cap = 0;
+    u32 max_id = 0;
+
+    inline
+    void _Place(u32 at, T element, u32 id) {
+        lst[at] = element;
+        if (pos) {
+            ids[at] = id;
+            pos[id] = at;
+        }
+    }
+    inline
+    u32 _Id(u32 at) {
+        return ids ? ids[at] : 0;
+    }
+    void _SiftUp(u32 at, T element, u32 id) {
+        while (at > 0) {
+            u32 parent = (at - 1) / D;
+            if (!(element < lst[parent])) {
+                break;
+            }
+            _Place(at, lst[parent], _Id(parent));
+            at = parent;
+        }
+        _Place(at, element, id);
+    }
+    void _SiftDown(u32 at, T element, u32 id) {
+        while (true) {
+            u32 first = at * D + 1;
+            if (first >= len) {
+                break;
+            }
+            u32 end = MinU32(first + D, len);
+            u32 best = first;
+            for (u32 c = first + 1; c < end; ++c) {
+                if (lst[c] < lst[best]) {
+                    best = c;
+                }
+            }
+            if (!(lst[best] < element)) {
+                break;
+            }
+            _Place(at, lst[best], _Id(best));
+            at = best;
+        }
+        _Place(at, element, id);
+    }
+
+    inline
+    void Push(T element, u32 id = 0) {
+        assert(len < cap);
+        if (pos) {
+            assert(id < max_id && pos[id] == HEAP_NOT_PRESENT && "id must be in range and not already in the heap");
+        }
+        _SiftUp(len++, element, id);
+    }
+    inline
+    T Peek() {
+        assert(len > 0);
+        return lst[0];
+    }
+    inline
+    T Pop(u32 *id = NULL) {
+        assert(len > 0);
+        T top = lst[0];
+        if (pos) {
+            if (id) {
+                *id = ids[0];
+            }
+            pos[ids[0]] = HEAP_NOT_PRESENT;
+        }
+        --len;
+        if (len > 0) {
+            // bottom-up: walk the hole down along min children, then sift the former last element up from there
+            u32 at = 0;
+            u32 first;
+            while ((first = at * D + 1) < len) {
+                u32 end = MinU32(first + D, len);
+                u32 best = first;
+                for (u32 c = first + 1; c < end; ++c) {
+                    if (lst[c] < lst[best]) {
+                        best = c;
+                    }
+                }
+                _Place(at, lst[best], _Id(best));
+                at = best;
+            }
+            _SiftUp(at, lst[len], _Id(len));
+        }
+        return top;
+    }
+    inline
+    bool Contains(u32 id) {
+        assert(pos && id < max_id);
+        return pos[id] != HEAP_NOT_PRESENT;
+    }
+    inline
+    T Get(u32 id) {
+        assert(Contains(id));
+        return lst[pos[id]];
+    }
+    void DecreaseKey(u32 id, T element) {
+        assert(Contains(id));
+        u32 at = pos[id];
+        assert(!(lst[at] < element) && "DecreaseKey must not increase the key");
+        _SiftUp(at, element, id);
+    }
+    void Heapify(T *elements, u32 cnt, u32 *element_ids = NULL) {
+        // bulk build in O(n), replaces the current contents; an indexed heap without element_ids uses ids 0 .. cnt-1
+        assert(cnt <= cap);
+        if (pos) {
+            assert(element_ids != NULL || cnt <= max_id);
+            memset(pos, 0xFF, sizeof(u32) * max_id);
+            for (u32 i = 0; i < cnt; ++i) {
+                ids[i] = element_ids ? element_ids[i] : i;
+                assert(ids[i] < max_id && pos[ids[i]] == HEAP_NOT_PRESENT && "ids must be in range and unique");
+                pos[ids[i]] = i;
+            }
+        }
+        memcpy(lst, elements, sizeof(T) * cnt);
+        len = cnt;
+
+        if (len > 1) {
+            for (s64 i = (len - 2) / D; i >= 0; --i) {
+                _SiftDown((u32) i, lst[i], _Id((u32) i));
+            }
+        }
+    }
+    inline
+    void Clear() {
+        if (pos) {
+            for (u32 i = 0; i < len; ++i) {
+                pos[ids[i]] = HEAP_NOT_PRESENT;
+            }
+        }
+        len = 0;
+    }
+};
+
+template<class T, u32 D = 4>
+Heap<T, D> InitHeap(MArena *a, u32 cap) {
+    Heap<T, D> heap;
+    heap.lst = (T*) ArenaAlloc(a, sizeof(T) * cap, false);
+    heap.cap = cap;
+    return heap;
+}
+
+template<class T, u32 D = 4>
+Heap<T, D> InitHeapIndexed(MArena *a, u32 cap, u32 max_id) {
+    Heap<T, D> heap = InitHeap<T, D>(a, cap);
+    heap.ids = (u32*) ArenaAlloc(a, sizeof(u32) * cap, false);
+    heap.pos = (u32*) ArenaAlloc(a, sizeof(u32) * max_id, false);
+    heap.max_id = max_id;
+    memset(heap.pos, 0xFF, sizeof(u32) * max_id);
+    return heap;
+}
+
+
 //
 // Self-expanding array
 
@@ -612,6 +800,261 @@ struct ListX {
 };
 
 
+//
+// Bucket array
+//
+// Segmented list that grows in fixed-size, power-of-two chunks taken from an arena or a pool. Elements never
+// move, so pointers to them stay valid for the lifetime of the container. Indexed access goes through a chunk
+// directory, which is the only thing that is reallocated on growth. Iterate chunk-wise using GetChunk().
+/*
+    BucketArray<Entity> ents = InitBucketArray<Entity>(a, 256);
+    Entity *e = ents.Add({});
+
+    for (u32 c = 0; c < ents.ChunkCount(); ++c) {
+        u32 cnt;
+        Entity *chunk = ents.GetChunk(c, &cnt);
+        ...
+    }
+*/
+
+
+template<typename T>
+struct BucketArray {
+    T **chunks = NULL;
+    MArena *a_dir = NULL;   // directory, and chunks when p_chunks is NULL
+    MPool *p_chunks = NULL;
+    u32 len = 0;
+    u32 nchunks = 0;        // allocated chunks, may exceed what len uses after Clear()
+    u32 chunks_cap = 0;
+    u32 chunk_shift = 0;
+    u32 chunk_mask = 0;
+
+    bool _AddChunk() {
+        if (nchunks == chunks_cap) {
+            u32 cap = MaxU32(16, chunks_cap * 2);
+            T **dir = (T**) ArenaAlloc(a_dir, sizeof(T*) * cap, false);
+            if (nchunks) {
+                memcpy(dir, chunks, sizeof(T*) * nchunks);
+            }
+            chunks = dir;
+            chunks_cap = cap;
+        }
+
+        T *chunk;
+        if (p_chunks) {
+            chunk = (T*) PoolAlloc(p_chunks);
+            if (chunk == NULL) {
+                return false;
+            }
+        }
+        else {
+            chunk = (T*) ArenaAlloc(a_dir, sizeof(T) << chunk_shift, false);
+        }
+        chunks[nchunks++] = chunk;
+        return true;
+    }
+    inline
+    T *Add(T element) {
+        // returns NULL if the chunk pool is exhausted
+        if ((len >> chunk_shift) == nchunks) {
+            if (_AddChunk() == false) {
+                return NULL;
+            }
+        }
+        T *dest = chunks[len >> chunk_shift] + (len & chunk_mask);
+        *dest = element;
+        len++;
+        return dest;
+    }
+    inline
+    T *GetPtr(u32 idx) {
+        assert(idx < len);
+        return chunks[idx >> chunk_shift] + (idx & chunk_mask);
+    }
+    inline
+    T Get(u32 idx) {
+        return *GetPtr(idx);
+    }
+    inline
+    u32 ChunkLen() {
+        return chunk_mask + 1;
+    }
+    inline
+    u32 ChunkCount() {
+        // chunks in use
+        return (len + chunk_mask) >> chunk_shift;
+    }
+    inline
+    T *GetChunk(u32 chunk_idx, u32 *cnt) {
+        assert(chunk_idx < ChunkCount());
+        u32 first = chunk_idx << chunk_shift;
+        *cnt = MinU32(len - first, ChunkLen());
+        return chunks[chunk_idx];
+    }
+    inline
+    void Clear() {
+        // keeps allocated chunks for re-use
+        len = 0;
+    }
+    void Release() {
+        // returns all chunks to the pool, pool-backed arrays only
+        assert(p_chunks != NULL);
+        for (u32 i = 0; i < nchunks; ++i) {
+            PoolFree(p_chunks, chunks[i]);
+        }
+        nchunks = 0;
+        len = 0;
+    }
+};
+
+template<class T>
+BucketArray<T> InitBucketArray(MArena *a, u32 chunk_len = 256) {
+    assert(chunk_len > 0);
+
+    BucketArray<T> arr;
+    arr.a_dir = a;
+    while ((1u << arr.chunk_shift) < chunk_len) {
+        arr.chunk_shift++;
+    }
+    arr.chunk_mask = (1 << arr.chunk_shift) - 1;
+    return arr;
+}
+
+template<class T>
+BucketArray<T> InitBucketArray(MArena *a_dir, MPool *p_chunks) {
+    // chunks are pool blocks, holding the largest power-of-two number of elements that fits
+    assert(p_chunks->block_size >= sizeof(T));
+
+    BucketArray<T> arr;
+    arr.a_dir = a_dir;
+    arr.p_chunks = p_chunks;
+    while ((sizeof(T) << (arr.chunk_shift + 1)) <= p_chunks->block_size) {
+        arr.chunk_shift++;
+    }
+    arr.chunk_mask = (1 << arr.chunk_shift) - 1;
+    return arr;
+}
+
+
+//
+// Slot map
+//
+// Fixed-capacity container handing out generation-checked keys. Values are packed in a dense array, so iteration
+// is a linear scan over lst[0..len), while keys resolve through a sparse slot array. Insert and Remove are O(1);
+// Remove swaps the last value into the hole, so dense positions change but keys stay valid. A removed key goes
+// stale for good, as its slot's generation is bumped before the slot is re-used.
+
+
+struct SlotKey {
+    u32 idx;
+    u32 gen; // 0 is never handed out, a zero key is the NULL key
+
+    inline
+    u64 Packed() {
+        return ((u64) gen << 32) | idx;
+    }
+};
+
+inline
+SlotKey SlotKeyUnpack(u64 packed) {
+    return SlotKey { (u32) packed, (u32) (packed >> 32) };
+}
+
+template<typename T>
+struct SlotMap {
+    T *lst = NULL;            // dense values
+    u32 *dense_slot = NULL;   // dense idx -> slot idx
+    u32 *slot_dense = NULL;   // slot idx -> dense idx, or the next free slot for vacant slots
+    u32 *slot_gen = NULL;
+    u32 len = 0;
+    u32 cap = 0;
+    u32 nslots = 0;           // slots touched so far
+    u32 free_slot = 0;        // head of the vacant slot list, cap means empty
+
+    SlotKey Insert(T element) {
+        // returns the zero key when full
+        if (len == cap) {
+            return SlotKey {};
+        }
+        u32 slot;
+        if (free_slot != cap) {
+            slot = free_slot;
+            free_slot = slot_dense[slot];
+        }
+        else {
+            slot = nslots++;
+            slot_gen[slot] = 1;
+        }
+        slot_dense[slot] = len;
+        dense_slot[len] = slot;
+        lst[len] = element;
+        len++;
+
+        return SlotKey { slot, slot_gen[slot] };
+    }
+    inline
+    bool Contains(SlotKey key) {
+        return key.idx < nslots && key.gen != 0 && slot_gen[key.idx] == key.gen;
+    }
+    inline
+    T *Get(SlotKey key) {
+        if (Contains(key) == false) {
+            return NULL;
+        }
+        return lst + slot_dense[key.idx];
+    }
+    bool Remove(SlotKey key) {
+        if (Contains(key) == false) {
+            return false;
+        }
+        u32 slot = key.idx;
+        u32 at = slot_dense[slot];
+
+        // swap-remove in the dense array
+        len--;
+        if (at != len) {
+            lst[at] = lst[len];
+            dense_slot[at] = dense_slot[len];
+            slot_dense[dense_slot[at]] = at;
+        }
+
+        // retire the key and push the slot on the vacant list
+        slot_gen[slot]++;
+        if (slot_gen[slot] == 0) {
+            slot_gen[slot] = 1;
+        }
+        slot_dense[slot] = free_slot;
+        free_slot = slot;
+        return true;
+    }
+    inline
+    SlotKey KeyAt(u32 dense_idx) {
+        // key of the value at a dense position, e.g. while iterating
+        assert(dense_idx < len);
+        u32 slot = dense_slot[dense_idx];
+        return SlotKey { slot, slot_gen[slot] };
+    }
+    void Clear() {
+        // invalidates all outstanding keys
+        while (len) {
+            Remove(KeyAt(len - 1));
+        }
+    }
+};
+
+template<class T>
+SlotMap<T> InitSlotMap(MArena *a, u32 cap) {
+    SlotMap<T> map;
+    map.lst = (T*) ArenaAlloc(a, sizeof(T) * cap, false);
+    map.dense_slot = (u32*) ArenaAlloc(a, sizeof(u32) * cap, false);
+    map.slot_dense = (u32*) ArenaAlloc(a, sizeof(u32) * cap, false);
+    map.slot_gen = (u32*) ArenaAlloc(a, sizeof(u32) * cap, true);
+    map.cap = cap;
+    map.free_slot = cap;
+    return map;
+}
+
+
 //
 // Stretchy buffer
 //
@@ -687,54 +1130,596 @@ void SortBubbleU32(List<u32> arr) {
     }
 }
 
-List<u32> SetIntersectionU32(MArena *a_dest, List<u32> arr_a, List<u32> arr_b) {
-    List<u32> result = InitList<u32>(a_dest, 0);
-    if (arr_a.len == 0 || arr_b.len == 0) {
-        return result;
+//
+//  Sorted-set algebra
+//
+//  Inputs must be sorted ascending. Duplicates are allowed and collapse in the output, which is always strictly
+//  increasing. The raw kernels write to a caller-provided dest and return the count; dest must hold
+//  min(na, nb) values for intersection, na + nb for union and na for difference.
+//  The List<u32> wrappers pre-size the result on the arena and shed the unused tail afterwards.
+
+
+#define SET_GALLOP_RATIO 32
+
+
+inline
+u32 SetGallopU32(u32 *lst, u32 lo, u32 len, u32 val) {
+    // returns the first idx >= lo where lst[idx] >= val, or len
+    if (lo >= len || lst[lo] >= val) {
+        return lo;
+    }
+
+    // exponential search for an upper bound, lst[lo] < val holds throughout
+    u32 step = 1;
+    u32 hi = lo + step;
+    while (hi < len && lst[hi] < val) {
+        lo = hi;
+        step <<= 1;
+        hi = lo + step;
+    }
+    if (hi > len) {
+        hi = len;
+    }
+
+    // binary search in (lo, hi]
+    while (lo + 1 < hi) {
+        u32 mid = lo + (hi - lo) / 2;
+        if (lst[mid] < val) {
+            lo = mid;
+        }
+        else {
+            hi = mid;
+        }
+    }
+    return hi;
+}
+
+inline
+void _SetEmitU32(u32 *dest, u32 *cnt, u32 val) {
+    if (*cnt == 0 || dest[*cnt - 1] != val) {
+        dest[(*cnt)++] = val;
+    }
+}
+
+u32 _SetIntersectScalarU32(u32 *a, u32 na, u32 *b, u32 nb, u32 *dest, u32 cnt = 0, u32 i = 0, u32 j = 0) {
+    while (i < na && j < nb) {
+        u32 va = a[i];
+        u32 vb = b[j];
+        if (va == vb) {
+            _SetEmitU32(dest, &cnt, va);
+        }
+        i += (va <= vb);
+        j += (vb <= va);
+    }
+    return cnt;
+}
+
+u32 _SetIntersectGallopU32(u32 *small, u32 nsmall, u32 *large, u32 nlarge, u32 *dest) {
+    u32 cnt = 0;
+    u32 j = 0;
+    for (u32 i = 0; i < nsmall; ++i) {
+        u32 val = small[i];
+        j = SetGallopU32(large, j, nlarge, val);
+        if (j == nlarge) {
+            break;
+        }
+        if (large[j] == val) {
+            _SetEmitU32(dest, &cnt, val);
+        }
     }
-    SortBubbleU32(arr_a);
-    SortBubbleU32(arr_b);
+    return cnt;
+}
+
+#if SIMD_AVX2
+#define SET_BLOCK 8
+inline
+u32 _SetBlockMatchMaskU32(u32 *a, u32 *b) {
+    // bit k set: a[k] equals some element in b[0..8)
+    __m256i va = _mm256_loadu_si256((__m256i*) a);
+    __m256i vb = _mm256_loadu_si256((__m256i*) b);
+    __m256i rot = _mm256_setr_epi32(1, 2, 3, 4, 5, 6, 7, 0);
+    __m256i eq = _mm256_cmpeq_epi32(va, vb);
+    for (u32 r = 1; r < 8; ++r) {
+        vb = _mm256_permutevar8x32_epi32(vb, rot);
+        eq = _mm256_or_si256(eq, _mm256_cmpeq_epi32(va, vb));
+    }
+    return (u32) _mm256_movemask_ps(_mm256_castsi256_ps(eq));
+}
+#elif SIMD_SSE2
+#define SET_BLOCK 4
+inline
+u32 _SetBlockMatchMaskU32(u32 *a, u32 *b) {
+    // bit k set: a[k] equals some element in b[0..4)
+    __m128i va = _mm_loadu_si128((__m128i*) a);
+    __m128i vb = _mm_loadu_si128((__m128i*) b);
+    __m128i eq = _mm_cmpeq_epi32(va, vb);
+    vb = _mm_shuffle_epi32(vb, _MM_SHUFFLE(0, 3, 2, 1));
+    eq = _mm_or_si128(eq, _mm_cmpeq_epi32(va, vb));
+    vb = _mm_shuffle_epi32(vb, _MM_SHUFFLE(0, 3, 2, 1));
+    eq = _mm_or_si128(eq, _mm_cmpeq_epi32(va, vb));
+    vb = _mm_shuffle_epi32(vb, _MM_SHUFFLE(0, 3, 2, 1));
+    eq = _mm_or_si128(eq, _mm_cmpeq_epi32(va, vb));
+    return (u32) _mm_movemask_ps(_mm_castsi128_ps(eq));
+}
+#endif
 
-    u32 min = MaxU32(arr_a.First(), arr_b.First());
-    u32 max = MinU32(arr_a.Last(), arr_b.Last());
+u32 _SetIntersectBlockU32(u32 *a, u32 na, u32 *b, u32 nb, u32 *dest) {
+    u32 cnt = 0;
     u32 i = 0;
     u32 j = 0;
-    u32 i_max = arr_a.len - 1;
-    u32 j_max = arr_b.len - 1;
 
-    // fast-forward both arrays to min value
-    u32 a = arr_a.First();
-    u32 b = arr_b.First();
-    while (a < min) {
-        a = arr_a.lst[++i];
+    #ifdef SET_BLOCK
+    // all-pairs compare a block of a against a block of b, then advance the block with the smaller max
+    while (i + SET_BLOCK <= na && j + SET_BLOCK <= nb) {
+        u32 mask = _SetBlockMatchMaskU32(a + i, b + j);
+        while (mask) {
+            _SetEmitU32(dest, &cnt, a[i + CtzU32(mask)]);
+            mask &= mask - 1;
+        }
+
+        u32 amax = a[i + SET_BLOCK - 1];
+        u32 bmax = b[j + SET_BLOCK - 1];
+        i += (amax <= bmax) * SET_BLOCK;
+        j += (bmax <= amax) * SET_BLOCK;
+    }
+    #endif
+
+    return _SetIntersectScalarU32(a, na, b, nb, dest, cnt, i, j);
+}
+
+u32 SetIntersectionU32(u32 *a, u32 na, u32 *b, u32 nb, u32 *dest) {
+    if (na == 0 || nb == 0) {
+        return 0;
+    }
+    if (na > nb * SET_GALLOP_RATIO) {
+        return _SetIntersectGallopU32(b, nb, a, na, dest);
     }
-    while (b < min) {
-        b = arr_b.lst[++j];
+    if (nb > na * SET_GALLOP_RATIO) {
+        return _SetIntersectGallopU32(a, na, b, nb, dest);
     }
+    return _SetIntersectBlockU32(a, na, b, nb, dest);
+}
 
-    // do the intersection work until we reach max value
-    while (i <= i_max && j <= j_max && a <= max && b <= max) {
-        if (a == b) {
-            if (result.len == 0 || (result.len > 0 && a != result.Last())) {
-                ArenaAlloc(a_dest, sizeof(u32));
-                result.Add(a);
-            }
-            a = arr_a.lst[++i];
-            b = arr_b.lst[++j];
+u32 _SetCopyRunU32(u32 *src, u32 from, u32 to, u32 *dest, u32 cnt) {
+    // append src[from..to), collapsing duplicates
+    if (from < to) {
+        _SetEmitU32(dest, &cnt, src[from++]);
+    }
+    while (from < to) {
+        u32 val = src[from++];
+        dest[cnt] = val;
+        cnt += (val != dest[cnt - 1]);
+    }
+    return cnt;
+}
+
+u32 _SetUnionGallopU32(u32 *small, u32 nsmall, u32 *large, u32 nlarge, u32 *dest) {
+    // bulk-copy runs of the large list that lie between consecutive elements of the small list
+    u32 cnt = 0;
+    u32 j = 0;
+    for (u32 i = 0; i < nsmall; ++i) {
+        u32 val = small[i];
+        u32 j_next = SetGallopU32(large, j, nlarge, val);
+        cnt = _SetCopyRunU32(large, j, j_next, dest, cnt);
+        _SetEmitU32(dest, &cnt, val);
+        j = j_next;
+    }
+    return _SetCopyRunU32(large, j, nlarge, dest, cnt);
+}
+
+u32 _SetUnionMergeU32(u32 *a, u32 na, u32 *b, u32 nb, u32 *dest) {
+    u32 cnt = 0;
+    u32 i = 0;
+    u32 j = 0;
+    while (i < na && j < nb) {
+        u32 va = a[i];
+        u32 vb = b[j];
+        _SetEmitU32(dest, &cnt, va <= vb ? va : vb);
+        i += (va <= vb);
+        j += (vb <= va);
+    }
+    cnt = _SetCopyRunU32(a, i, na, dest, cnt);
+    cnt = _SetCopyRunU32(b, j, nb, dest, cnt);
+    return cnt;
+}
+
+u32 SetUnionU32(u32 *a, u32 na, u32 *b, u32 nb, u32 *dest) {
+    if (na > nb * SET_GALLOP_RATIO) {
+        return _SetUnionGallopU32(b, nb, a, na, dest);
+    }
+    if (nb > na * SET_GALLOP_RATIO) {
+        return _SetUnionGallopU32(a, na, b, nb, dest);
+    }
+    return _SetUnionMergeU32(a, na, b, nb, dest);
+}
+
+u32 _SetDifferenceScalarU32(u32 *a, u32 na, u32 *b, u32 nb, u32 *dest, u32 cnt = 0, u32 i = 0, u32 j = 0, u32 matched = 0) {
+    // bits in matched flag the elements a[i + k] already known to be in b
+    for (; i < na; ++i, matched >>= 1) {
+        u32 val = a[i];
+        if (matched & 1) {
+            continue;
+        }
+        while (j < nb && b[j] < val) {
+            ++j;
+        }
+        if (j == nb || b[j] != val) {
+            _SetEmitU32(dest, &cnt, val);
+        }
+    }
+    return cnt;
+}
+
+u32 _SetDifferenceGallopU32(u32 *a, u32 na, u32 *b, u32 nb, u32 *dest) {
+    // a is the small list, gallop through b
+    u32 cnt = 0;
+    u32 j = 0;
+    for (u32 i = 0; i < na; ++i) {
+        u32 val = a[i];
+        j = SetGallopU32(b, j, nb, val);
+        if (j == nb || b[j] != val) {
+            _SetEmitU32(dest, &cnt, val);
         }
-        else if (a < b) {
-            while (a < b && i < i_max) {
-                a = arr_a.lst[++i];
+    }
+    return cnt;
+}
+
+u32 _SetDifferenceBlockU32(u32 *a, u32 na, u32 *b, u32 nb, u32 *dest) {
+    u32 cnt = 0;
+    u32 i = 0;
+    u32 j = 0;
+    u32 matched = 0;
+
+    #ifdef SET_BLOCK
+    // accumulate matches for the current block of a over every block of b that overlaps it
+    while (i + SET_BLOCK <= na && j + SET_BLOCK <= nb) {
+        matched |= _SetBlockMatchMaskU32(a + i, b + j);
+
+        u32 amax = a[i + SET_BLOCK - 1];
+        u32 bmax = b[j + SET_BLOCK - 1];
+        if (amax <= bmax) {
+            // NOTE: b is not advanced on equality, duplicates of amax may follow in a
+            for (u32 k = 0; k < SET_BLOCK; ++k) {
+                if ((matched & (1 << k)) == 0) {
+                    _SetEmitU32(dest, &cnt, a[i + k]);
+                }
             }
+            i += SET_BLOCK;
+            matched = 0;
         }
-        else if (b < a) {
-            while (b < a && j < j_max) {
-                b = arr_b.lst[++j];
+        else {
+            j += SET_BLOCK;
+        }
+    }
+    #endif
+
+    return _SetDifferenceScalarU32(a, na, b, nb, dest, cnt, i, j, matched);
+}
+
+u32 SetDifferenceU32(u32 *a, u32 na, u32 *b, u32 nb, u32 *dest) {
+    if (nb == 0) {
+        return _SetCopyRunU32(a, 0, na, dest, 0);
+    }
+    if (nb > na * SET_GALLOP_RATIO) {
+        return _SetDifferenceGallopU32(a, na, b, nb, dest);
+    }
+    return _SetDifferenceBlockU32(a, na, b, nb, dest);
+}
+
+List<u32> _SetResultShed(MArena *a_dest, List<u32> result, u32 cap) {
+    if (a_dest->mem + a_dest->used == (u8*) (result.lst + cap)) {
+        ArenaShedTail(a_dest, result, cap - result.len);
+    }
+    return result;
+}
+
+List<u32> SetIntersectionU32(MArena *a_dest, List<u32> arr_a, List<u32> arr_b) {
+    u32 cap = MinU32(arr_a.len, arr_b.len);
+    List<u32> result = InitList<u32>(a_dest, cap, false);
+    result.len = SetIntersectionU32(arr_a.lst, arr_a.len, arr_b.lst, arr_b.len, result.lst);
+    return _SetResultShed(a_dest, result, cap);
+}
+
+List<u32> SetUnionU32(MArena *a_dest, List<u32> arr_a, List<u32> arr_b) {
+    u32 cap = arr_a.len + arr_b.len;
+    List<u32> result = InitList<u32>(a_dest, cap, false);
+    result.len = SetUnionU32(arr_a.lst, arr_a.len, arr_b.lst, arr_b.len, result.lst);
+    return _SetResultShed(a_dest, result, cap);
+}
+
+List<u32> SetDifferenceU32(MArena *a_dest, List<u32> arr_a, List<u32> arr_b) {
+    u32 cap = arr_a.len;
+    List<u32> result = InitList<u32>(a_dest, cap, false);
+    result.len = SetDifferenceU32(arr_a.lst, arr_a.len, arr_b.lst, arr_b.len, result.lst);
+    return _SetResultShed(a_dest, result, cap);
+}
+
+
+
+//
+//  Compressed integer lists
+//
+//  Sorted u32 lists stored as deltas in blocks of PACKED_BLOCK_LEN values, either with StreamVByte (2-bit length
+//  codes + 1-4 data bytes per value, decoded four at a time with a shuffle table) or with frame-of-reference
+//  bit-packing (one bit width per block). A skip entry per block holds its first value and byte offset, so blocks
+//  decode independently and PackedIter::SkipTo() binary-searches the skips before touching any data.
+/*
+    PackedU32 packed = PackU32(a, ids);
+
+    PackedIter iter = InitPackedIter(&packed);
+    u32 id;
+    while (iter.Next(&id)) {
+        ...
+    }
+*/
+
+
+#define PACKED_BLOCK_LEN 128
+#define PACKED_BLOCK_MAX (PACKED_BLOCK_LEN * 4 + PACKED_BLOCK_LEN / 4 + 1)
+#define PACKED_PADDING 16 // decoders read up to 16 bytes past a block
+
+
+enum PackCodec {
+    PACK_STREAMVBYTE,
+    PACK_BITPACK,
+};
+
+struct PackedSkip {
+    u32 first;
+    u32 offset;
+};
+
+struct PackedU32 {
+    u8 *data;
+    PackedSkip *skips;
+    u32 data_len;
+    u32 nblocks;
+    u32 len;
+    PackCodec codec;
+
+    u64 SizeBytes() {
+        return (u64) data_len + sizeof(PackedSkip) * nblocks;
+    }
+};
+
+
+struct SVBTables {
+    u8 shuffle[256][16];    // gathers the data bytes of four values, by control byte
+    u8 len[256];            // data bytes covered by a control byte
+};
+
+SVBTables _SVBBuild() {
+    SVBTables t = {};
+    for (u32 c = 0; c < 256; ++c) {
+        u32 at = 0;
+        for (u32 k = 0; k < 4; ++k) {
+            u32 nbytes = ((c >> (2 * k)) & 3) + 1;
+            for (u32 b = 0; b < 4; ++b) {
+                t.shuffle[c][4 * k + b] = (b < nbytes) ? (u8) (at + b) : 0xFF;
             }
+            at += nbytes;
+        }
+        t.len[c] = (u8) at;
+    }
+    return t;
+}
+
+SVBTables *SVBGetTables() {
+    // built once, on first use (thread-safe)
+    static SVBTables tables = _SVBBuild();
+    return &tables;
+}
+
+u32 _PackedEncodeSVB(u32 *deltas, u32 n, u8 *dest) {
+    u8 *ctrl = dest;
+    u8 *data = dest + (n + 3) / 4;
+    memset(ctrl, 0, (n + 3) / 4);
+    for (u32 i = 0; i < n; ++i) {
+        u32 d = deltas[i];
+        u32 code = (d > 0xFFFFFF) ? 3 : (d > 0xFFFF) ? 2 : (d > 0xFF) ? 1 : 0;
+        ctrl[i / 4] |= (u8) (code << (2 * (i % 4)));
+        memcpy(data, &d, code + 1);
+        data += code + 1;
+    }
+    return (u32) (data - dest);
+}
+
+void _PackedDecodeSVB(u8 *src, u32 n, u32 first, u32 *dest) {
+    u8 *ctrl = src;
+    u8 *data = src + (n + 3) / 4;
+    u32 prev = first;
+    u32 i = 0;
+
+    #if SIMD_SSSE3
+    SVBTables *t = SVBGetTables();
+    __m128i prev_v = _mm_set1_epi32((s32) first);
+    for (; i + 4 <= n; i += 4) {
+        u8 c = ctrl[i / 4];
+        __m128i v = _mm_shuffle_epi8(_mm_loadu_si128((__m128i*) data), _mm_loadu_si128((__m128i*) t->shuffle[c]));
+        data += t->len[c];
+
+        // prefix sum over the four deltas
+        v = _mm_add_epi32(v, _mm_slli_si128(v, 4));
+        v = _mm_add_epi32(v, _mm_slli_si128(v, 8));
+        v = _mm_add_epi32(v, prev_v);
+        _mm_storeu_si128((__m128i*) (dest + i), v);
+        prev_v = _mm_shuffle_epi32(v, 0xFF);
+    }
+    if (i) {
+        prev = dest[i - 1];
+    }
+    #endif
+
+    for (; i < n; ++i) {
+        u32 code = (ctrl[i / 4] >> (2 * (i % 4))) & 3;
+        u32 d;
+        memcpy(&d, data, 4);
+        d &= 0xFFFFFFFF >> (24 - 8 * code);
+        data += code + 1;
+        prev += d;
+        dest[i] = prev;
+    }
+}
+
+u32 _PackedEncodeBits(u32 *deltas, u32 n, u8 *dest) {
+    u32 all = 0;
+    for (u32 i = 0; i < n; ++i) {
+        all |= deltas[i];
+    }
+    u32 bits = all ? 32 - ClzU32(all) : 0;
+    u32 nbytes = (n * bits + 7) / 8;
+
+    dest[0] = (u8) bits;
+    u8 *data = dest + 1;
+    memset(data, 0, nbytes + 8);
+    u64 bitpos = 0;
+    for (u32 i = 0; i < n; ++i) {
+        u64 word;
+        memcpy(&word, data + (bitpos >> 3), 8);
+        word |= (u64) deltas[i] << (bitpos & 7);
+        memcpy(data + (bitpos >> 3), &word, 8);
+        bitpos += bits;
+    }
+    return 1 + nbytes;
+}
+
+void _PackedDecodeBits(u8 *src, u32 n, u32 first, u32 *dest) {
+    u32 bits = src[0];
+    u8 *data = src + 1;
+    u64 mask = ((u64) 1 << bits) - 1;
+    u32 prev = first;
+    u64 bitpos = 0;
+    for (u32 i = 0; i < n; ++i) {
+        u64 word;
+        memcpy(&word, data + (bitpos >> 3), 8);
+        prev += (u32) ((word >> (bitpos & 7)) & mask);
+        dest[i] = prev;
+        bitpos += bits;
+    }
+}
+
+PackedU32 PackU32(MArena *a_dest, List<u32> sorted, PackCodec codec = PACK_STREAMVBYTE) {
+    PackedU32 packed = {};
+    packed.len = sorted.len;
+    packed.codec = codec;
+    packed.nblocks = (sorted.len + PACKED_BLOCK_LEN - 1) / PACKED_BLOCK_LEN;
+    packed.skips = (PackedSkip*) ArenaAllocAligned(a_dest, sizeof(PackedSkip) * packed.nblocks, alignof(PackedSkip), false);
+
+    u64 cap = (u64) PACKED_BLOCK_MAX * packed.nblocks + PACKED_PADDING;
+    packed.data = (u8*) ArenaAlloc(a_dest, cap, false);
+
+    u32 deltas[PACKED_BLOCK_LEN];
+    u32 at = 0;
+    for (u32 b = 0; b < packed.nblocks; ++b) {
+        u32 *vals = sorted.lst + b * PACKED_BLOCK_LEN;
+        u32 n = MinU32(PACKED_BLOCK_LEN, sorted.len - b * PACKED_BLOCK_LEN);
+
+        u32 prev = vals[0];
+        for (u32 i = 0; i < n; ++i) {
+            assert(vals[i] >= prev && "PackU32: input must be sorted");
+            deltas[i] = vals[i] - prev;
+            prev = vals[i];
+        }
+        packed.skips[b].first = vals[0];
+        packed.skips[b].offset = at;
+        if (codec == PACK_STREAMVBYTE) {
+            at += _PackedEncodeSVB(deltas, n, packed.data + at);
+        }
+        else {
+            at += _PackedEncodeBits(deltas, n, packed.data + at);
         }
     }
+    packed.data_len = at;
+    memset(packed.data + at, 0, PACKED_PADDING);
+
+    // give back the unused worst-case reserve
+    if (a_dest->mem + a_dest->used == packed.data + cap) {
+        a_dest->used -= cap - (at + PACKED_PADDING);
+    }
+    return packed;
+}
+
+u32 PackedDecodeBlock(PackedU32 *packed, u32 block, u32 *dest) {
+    // decodes one block into dest (PACKED_BLOCK_LEN capacity), returns the value count
+    assert(block < packed->nblocks);
+
+    u32 n = MinU32(PACKED_BLOCK_LEN, packed->len - block * PACKED_BLOCK_LEN);
+    u8 *src = packed->data + packed->skips[block].offset;
+    if (packed->codec == PACK_STREAMVBYTE) {
+        _PackedDecodeSVB(src, n, packed->skips[block].first, dest);
+    }
+    else {
+        _PackedDecodeBits(src, n, packed->skips[block].first, dest);
+    }
+    return n;
+}
+
+List<u32> UnpackU32(MArena *a_dest, PackedU32 *packed) {
+    List<u32> result = {};
+    result.lst = (u32*) ArenaAllocAligned(a_dest, sizeof(u32) * packed->len, alignof(u32), false);
+    for (u32 b = 0; b < packed->nblocks; ++b) {
+        result.len += PackedDecodeBlock(packed, b, result.lst + result.len);
+    }
     return result;
 }
 
+struct PackedIter {
+    PackedU32 *packed;
+    u32 block;
+    u32 pos;
+    u32 cnt;
+    u32 buf[PACKED_BLOCK_LEN];
+
+    bool Next(u32 *val) {
+        if (pos == cnt) {
+            if (block >= packed->nblocks) {
+                return false;
+            }
+            cnt = PackedDecodeBlock(packed, block++, buf);
+            pos = 0;
+        }
+        *val = buf[pos++];
+        return true;
+    }
+    bool SkipTo(u32 target, u32 *val) {
+        // advances to the first value >= target, never moving backwards
+        if (pos == cnt || buf[cnt - 1] < target) {
+            // last block starting at or below target, skipping blocks that start before the current one
+            u32 lo = block;
+            u32 hi = packed->nblocks;
+            while (lo < hi) {
+                u32 mid = (lo + hi) / 2;
+                if (packed->skips[mid].first <= target) {
+                    lo = mid + 1;
+                }
+                else {
+                    hi = mid;
+                }
+            }
+            u32 start = (lo > block) ? lo - 1 : block;
+            if (start >= packed->nblocks) {
+                pos = cnt;
+                block = packed->nblocks;
+                return false;
+            }
+            cnt = PackedDecodeBlock(packed, start, buf);
+            block = start + 1;
+            pos = 0;
+        }
+        while (Next(val)) {
+            if (*val >= target) {
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+PackedIter InitPackedIter(PackedU32 *packed) {
+    PackedIter iter = {};
+    iter.packed = packed;
+    return iter;
+}
+
 
 #endif
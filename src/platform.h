@@ -80,6 +80,8 @@ const char *getBuild() { // courtesy of S.O.
         #include <dirent.h>
         #include <unistd.h>
         #include <cstdlib>
+        #include <linux/futex.h>
+        #include <sys/syscall.h>
 
         // TODO: experiment with <x86intrin.h> alongside <sys/time.h> for the straight up __rdtsc() call
         // TODO: impl. LoadFile
@@ -132,6 +134,17 @@ const char *getBuild() { // courtesy of S.O.
             return ticks;
         }
 
+        //
+        // queue.h
+
+        void FutexWait(std::atomic<u32> *addr, u32 expected) {
+            // returns on wake, on spurious wake-up or immediately if *addr != expected
+            syscall(SYS_futex, (u32*) addr, FUTEX_WAIT_PRIVATE, expected, NULL, NULL, 0);
+        }
+        void FutexWake(std::atomic<u32> *addr, u32 cnt) {
+            syscall(SYS_futex, (u32*) addr, FUTEX_WAKE_PRIVATE, cnt, NULL, NULL, 0);
+        }
+
         //
         // utils.c
 
@@ -315,6 +328,23 @@ const char *getBuild() { // courtesy of S.O.
             return rd;
         }
 
+        //
+        // queue.h
+
+        #pragma comment(lib, "Synchronization.lib")
+
+        void FutexWait(std::atomic<u32> *addr, u32 expected) {
+            WaitOnAddress((volatile VOID*) addr, &expected, sizeof(u32), INFINITE);
+        }
+        void FutexWake(std::atomic<u32> *addr, u32 cnt) {
+            if (cnt == 1) {
+                WakeByAddressSingle((PVOID) addr);
+            }
+            else {
+                WakeByAddressAll((PVOID) addr);
+            }
+        }
+
         //
         // utils.h
 
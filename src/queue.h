@@ -0,0 +1,293 @@
+#ifndef __QUEUE_H__
+#define __QUEUE_H__
+
+#include <atomic>
+#include <thread>
+
+
+//
+// platform dependent:
+
+
+void FutexWait(std::atomic<u32> *addr, u32 expected);
+void FutexWake(std::atomic<u32> *addr, u32 cnt);
+
+
+//
+//  Bounded SPSC ring queue
+//
+//  Lock-free single-producer / single-consumer queue. Push/PushBatch may only be called from one thread and
+//  Pop/PopBatch from one (other) thread. Indices run freely and are masked on access, so cap is a power of two.
+//  Each side keeps a cached copy of the other side's index and only re-reads the shared one when the cached
+//  value says the queue is full (producer) or empty (consumer).
+
+
+template<typename T>
+struct QueueSPSC {
+    T *lst;
+    u32 cap;
+    u32 mask;
+
+    // consumer cache line
+    alignas(CACHE_LINE_SIZE) std::atomic<u32> head;
+    u32 tail_cached;
+
+    // producer cache line
+    alignas(CACHE_LINE_SIZE) std::atomic<u32> tail;
+    u32 head_cached;
+
+    u8 _pad[CACHE_LINE_SIZE - sizeof(std::atomic<u32>) - sizeof(u32)];
+
+    bool Push(T element) {
+        u32 t = tail.load(std::memory_order_relaxed);
+        if (t - head_cached == cap) {
+            head_cached = head.load(std::memory_order_acquire);
+            if (t - head_cached == cap) {
+                return false;
+            }
+        }
+        lst[t & mask] = element;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+    bool Pop(T *dest) {
+        u32 h = head.load(std::memory_order_relaxed);
+        if (h == tail_cached) {
+            tail_cached = tail.load(std::memory_order_acquire);
+            if (h == tail_cached) {
+                return false;
+            }
+        }
+        *dest = lst[h & mask];
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+    u32 PushBatch(T *elements, u32 cnt) {
+        // pushes as many as fit, returns the number pushed
+        u32 t = tail.load(std::memory_order_relaxed);
+        u32 space = cap - (t - head_cached);
+        if (space < cnt) {
+            head_cached = head.load(std::memory_order_acquire);
+            space = cap - (t - head_cached);
+        }
+        cnt = MinU32(cnt, space);
+        if (cnt == 0) {
+            return 0;
+        }
+
+        u32 at = t & mask;
+        u32 first = MinU32(cnt, cap - at);
+        memcpy(lst + at, elements, sizeof(T) * first);
+        memcpy(lst, elements + first, sizeof(T) * (cnt - first));
+
+        tail.store(t + cnt, std::memory_order_release);
+        return cnt;
+    }
+    u32 PopBatch(T *dest, u32 max) {
+        // pops up to max, returns the number popped
+        u32 h = head.load(std::memory_order_relaxed);
+        u32 avail = tail_cached - h;
+        if (avail < max) {
+            tail_cached = tail.load(std::memory_order_acquire);
+            avail = tail_cached - h;
+        }
+        u32 cnt = MinU32(max, avail);
+        if (cnt == 0) {
+            return 0;
+        }
+
+        u32 at = h & mask;
+        u32 first = MinU32(cnt, cap - at);
+        memcpy(dest, lst + at, sizeof(T) * first);
+        memcpy(dest + first, lst, sizeof(T) * (cnt - first));
+
+        head.store(h + cnt, std::memory_order_release);
+        return cnt;
+    }
+    u32 Len() {
+        // approximate when called concurrently
+        return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+    }
+};
+
+template<class T>
+u64 QueueSPSCMemSize(u32 cap) {
+    // bytes needed by InitQueueSPSCStatic, including alignment slack
+    return sizeof(QueueSPSC<T>) + sizeof(T) * cap + CACHE_LINE_SIZE;
+}
+
+template<class T>
+QueueSPSC<T> *InitQueueSPSCStatic(void *mem, u32 cap) {
+    assert(cap > 0 && (cap & (cap - 1)) == 0 && "cap must be a power of two");
+
+    u64 addr = (u64) mem;
+    addr = (addr + CACHE_LINE_SIZE - 1) & ~((u64) CACHE_LINE_SIZE - 1);
+    QueueSPSC<T> *q = (QueueSPSC<T>*) addr;
+    _memzero(q, sizeof(QueueSPSC<T>));
+    q->lst = (T*) (q + 1);
+    q->cap = cap;
+    q->mask = cap - 1;
+    q->head.store(0);
+    q->tail.store(0);
+    return q;
+}
+
+template<class T>
+QueueSPSC<T> *InitQueueSPSC(MArena *a, u32 cap) {
+    void *mem = ArenaAlloc(a, QueueSPSCMemSize<T>(cap), false);
+    return InitQueueSPSCStatic<T>(mem, cap);
+}
+
+
+//
+//  Bounded MPMC queue
+//
+//  Vyukov-style multi-producer / multi-consumer queue: every cell carries a sequence number telling whether it is
+//  ready to be written (seq == pos) or read (seq == pos + 1) in the current lap, so producers and consumers only
+//  contend on their own index with a single CAS. cap is a power of two.
+//
+//  TryPush/TryPop never block. Push/Pop block on a futex when the queue is full/empty, this requires init with
+//  blocking = true, which makes successful Try* calls check for sleepers.
+
+
+template<typename T>
+struct QueueMPMCCell {
+    std::atomic<u32> seq;
+    T data;
+};
+
+template<typename T>
+struct QueueMPMC {
+    QueueMPMCCell<T> *cells;
+    u32 cap;
+    u32 mask;
+    bool blocking;
+
+    alignas(CACHE_LINE_SIZE) std::atomic<u32> tail; // producers
+    alignas(CACHE_LINE_SIZE) std::atomic<u32> head; // consumers
+
+    // blocking mode: sleepers wait on an epoch that is bumped when the other side makes progress
+    alignas(CACHE_LINE_SIZE) std::atomic<u32> push_epoch;
+    std::atomic<u32> push_waiters;
+    alignas(CACHE_LINE_SIZE) std::atomic<u32> pop_epoch;
+    std::atomic<u32> pop_waiters;
+
+    u8 _pad[CACHE_LINE_SIZE - 2 * sizeof(std::atomic<u32>)];
+
+    inline
+    void _Signal(std::atomic<u32> *epoch, std::atomic<u32> *waiters) {
+        // pairs with the waiter registration in _Wait
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waiters->load(std::memory_order_relaxed)) {
+            epoch->fetch_add(1, std::memory_order_release);
+            FutexWake(epoch, 1);
+        }
+    }
+    bool TryPush(T element) {
+        u32 pos = tail.load(std::memory_order_relaxed);
+        QueueMPMCCell<T> *cell;
+        while (true) {
+            cell = cells + (pos & mask);
+            u32 seq = cell->seq.load(std::memory_order_acquire);
+            s32 dif = (s32) (seq - pos);
+            if (dif == 0) {
+                if (tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            }
+            else if (dif < 0) {
+                return false; // full
+            }
+            else {
+                pos = tail.load(std::memory_order_relaxed);
+            }
+        }
+        cell->data = element;
+        cell->seq.store(pos + 1, std::memory_order_release);
+
+        if (blocking) {
+            _Signal(&pop_epoch, &pop_waiters);
+        }
+        return true;
+    }
+    bool TryPop(T *dest) {
+        u32 pos = head.load(std::memory_order_relaxed);
+        QueueMPMCCell<T> *cell;
+        while (true) {
+            cell = cells + (pos & mask);
+            u32 seq = cell->seq.load(std::memory_order_acquire);
+            s32 dif = (s32) (seq - (pos + 1));
+            if (dif == 0) {
+                if (head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            }
+            else if (dif < 0) {
+                return false; // empty
+            }
+            else {
+                pos = head.load(std::memory_order_relaxed);
+            }
+        }
+        *dest = cell->data;
+        cell->seq.store(pos + mask + 1, std::memory_order_release);
+
+        if (blocking) {
+            _Signal(&push_epoch, &push_waiters);
+        }
+        return true;
+    }
+    void Push(T element) {
+        assert(blocking && "init with blocking = true to use Push");
+        while (TryPush(element) == false) {
+            push_waiters.fetch_add(1, std::memory_order_seq_cst);
+            u32 epoch = push_epoch.load(std::memory_order_acquire);
+            if (TryPush(element)) {
+                push_waiters.fetch_sub(1, std::memory_order_relaxed);
+                return;
+            }
+            FutexWait(&push_epoch, epoch);
+            push_waiters.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+    T Pop() {
+        assert(blocking && "init with blocking = true to use Pop");
+        T element;
+        while (TryPop(&element) == false) {
+            pop_waiters.fetch_add(1, std::memory_order_seq_cst);
+            u32 epoch = pop_epoch.load(std::memory_order_acquire);
+            if (TryPop(&element)) {
+                pop_waiters.fetch_sub(1, std::memory_order_relaxed);
+                break;
+            }
+            FutexWait(&pop_epoch, epoch);
+            pop_waiters.fetch_sub(1, std::memory_order_relaxed);
+        }
+        return element;
+    }
+    u32 Len() {
+        // approximate when called concurrently
+        return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+    }
+};
+
+template<class T>
+QueueMPMC<T> *InitQueueMPMC(MArena *a, u32 cap, bool blocking = false) {
+    assert(cap > 1 && (cap & (cap - 1)) == 0 && "cap must be a power of two");
+
+    QueueMPMC<T> *q = (QueueMPMC<T>*) ArenaAllocAligned(a, sizeof(QueueMPMC<T>), CACHE_LINE_SIZE);
+    q->cells = (QueueMPMCCell<T>*) ArenaAllocAligned(a, sizeof(QueueMPMCCell<T>) * cap, CACHE_LINE_SIZE);
+    q->cap = cap;
+    q->mask = cap - 1;
+    q->blocking = blocking;
+    for (u32 i = 0; i < cap; ++i) {
+        q->cells[i].seq.store(i, std::memory_order_relaxed);
+    }
+    q->tail.store(0);
+    q->head.store(0);
+    return q;
+}
+
+
+
+#endif
@@ -0,0 +1,692 @@
+#ifndef __TREE_H__
+#define __TREE_H__
+
+
+//
+//  Adaptive radix tree
+//
+//  Ordered map from byte-string keys to void* values, e.g. file paths. Inner nodes grow through 4, 16, 48 and 256
+//  child slots, compress single-child paths into a stored prefix and hold the value of a key ending at the node.
+//  Leaves hang directly off child slots (tagged pointers). Everything is arena allocated and the tree is
+//  insert-only; iteration is in lexicographic byte order, over everything, a key range or a key prefix.
+/*
+    ART tree = InitART(a);
+    ARTInsert(&tree, StrL("src/hash.h"), val);
+
+    ARTIter iter = ARTIterPrefix(a, &tree, StrL("src/"));
+    while (ARTLeaf *leaf = iter.Next()) {
+        StrPrint("", leaf->key, "\n");
+    }
+*/
+
+
+enum ARTNodeType {
+    ART_NODE4,
+    ART_NODE16,
+    ART_NODE48,
+    ART_NODE256,
+};
+
+struct ARTLeaf {
+    Str key;
+    void *val;
+};
+
+struct ARTNode {
+    u8 type;
+    u16 nchildren;
+    u32 prefix_len;
+    u8 *prefix;
+    ARTLeaf *leaf; // key ending at this node
+};
+
+struct ARTNode4 {
+    ARTNode hdr;
+    u8 keys[4];
+    void *children[4];
+};
+
+struct ARTNode16 {
+    ARTNode hdr;
+    u8 keys[16];
+    void *children[16];
+};
+
+struct ARTNode48 {
+    ARTNode hdr;
+    u8 index[256]; // byte -> child slot + 1, 0 is empty
+    void *children[48];
+};
+
+struct ARTNode256 {
+    ARTNode hdr;
+    void *children[256];
+};
+
+struct ART {
+    MArena *a;
+    void *root;
+    u32 len;
+    u32 max_key_len;
+};
+
+
+inline
+bool _ARTIsLeaf(void *ptr) {
+    return ((u64) ptr & 1) != 0;
+}
+
+inline
+ARTLeaf *_ARTLeaf(void *ptr) {
+    return (ARTLeaf*) ((u64) ptr & ~(u64) 1);
+}
+
+inline
+void *_ARTTagLeaf(ARTLeaf *leaf) {
+    return (void*) ((u64) leaf | 1);
+}
+
+s32 _ARTCompare(Str a, Str b) {
+    s32 cmp = memcmp(a.str, b.str, MinU32(a.len, b.len));
+    if (cmp != 0) {
+        return cmp;
+    }
+    return (a.len > b.len) - (a.len < b.len);
+}
+
+ART InitART(MArena *a_dest) {
+    ART tree = {};
+    tree.a = a_dest;
+    return tree;
+}
+
+ARTNode *_ARTAllocNode(ART *tree, u8 type) {
+    u64 size = 0;
+    switch (type) {
+        case ART_NODE4: { size = sizeof(ARTNode4); break; }
+        case ART_NODE16: { size = sizeof(ARTNode16); break; }
+        case ART_NODE48: { size = sizeof(ARTNode48); break; }
+        case ART_NODE256: { size = sizeof(ARTNode256); break; }
+        default: { assert(1 == 0); break; }
+    }
+    ARTNode *node = (ARTNode*) ArenaAllocAligned(tree->a, size, 8);
+    node->type = type;
+    return node;
+}
+
+void **_ARTFindChild(ARTNode *node, u8 byte) {
+    switch (node->type) {
+        case ART_NODE4: {
+            ARTNode4 *n = (ARTNode4*) node;
+            for (u32 i = 0; i < node->nchildren; ++i) {
+                if (n->keys[i] == byte) {
+                    return n->children + i;
+                }
+            }
+            return NULL;
+        }
+        case ART_NODE16: {
+            ARTNode16 *n = (ARTNode16*) node;
+            #if SIMD_SSE2
+            __m128i cmp = _mm_cmpeq_epi8(_mm_set1_epi8((char) byte), _mm_loadu_si128((__m128i*) n->keys));
+            u32 mask = (u32) _mm_movemask_epi8(cmp) & ((1u << node->nchildren) - 1);
+            if (mask) {
+                return n->children + CtzU32(mask);
+            }
+            #else
+            for (u32 i = 0; i < node->nchildren; ++i) {
+                if (n->keys[i] == byte) {
+                    return n->children + i;
+                }
+            }
+            #endif
+            return NULL;
+        }
+        case ART_NODE48: {
+            ARTNode48 *n = (ARTNode48*) node;
+            if (n->index[byte]) {
+                return n->children + n->index[byte] - 1;
+            }
+            return NULL;
+        }
+        case ART_NODE256: {
+            ARTNode256 *n = (ARTNode256*) node;
+            if (n->children[byte]) {
+                return n->children + byte;
+            }
+            return NULL;
+        }
+        default: {
+            return NULL;
+        }
+    }
+}
+
+void _ARTAddChild(ART *tree, void **ref, ARTNode *node, u8 byte, void *child) {
+    // adds to a node that has no child at byte, growing it into *ref when full
+    switch (node->type) {
+        case ART_NODE4:
+        case ART_NODE16: {
+            u32 cap = (node->type == ART_NODE4) ? 4 : 16;
+            u8 *keys = (node->type == ART_NODE4) ? ((ARTNode4*) node)->keys : ((ARTNode16*) node)->keys;
+            void **children = (node->type == ART_NODE4) ? ((ARTNode4*) node)->children : ((ARTNode16*) node)->children;
+
+            if (node->nchildren < cap) {
+                // keep keys sorted
+                u32 at = 0;
+                while (at < node->nchildren && keys[at] < byte) {
+                    at++;
+                }
+                memmove(keys + at + 1, keys + at, node->nchildren - at);
+                memmove(children + at + 1, children + at, sizeof(void*) * (node->nchildren - at));
+                keys[at] = byte;
+                children[at] = child;
+                node->nchildren++;
+                return;
+            }
+
+            ARTNode *grown;
+            if (node->type == ART_NODE4) {
+                ARTNode16 *n16 = (ARTNode16*) _ARTAllocNode(tree, ART_NODE16);
+                memcpy(n16->keys, keys, cap);
+                memcpy(n16->children, children, sizeof(void*) * cap);
+                grown = &n16->hdr;
+            }
+            else {
+                ARTNode48 *n48 = (ARTNode48*) _ARTAllocNode(tree, ART_NODE48);
+                for (u32 i = 0; i < cap; ++i) {
+                    n48->index[keys[i]] = (u8) (i + 1);
+                    n48->children[i] = children[i];
+                }
+                grown = &n48->hdr;
+            }
+            grown->nchildren = node->nchildren;
+            grown->prefix_len = node->prefix_len;
+            grown->prefix = node->prefix;
+            grown->leaf = node->leaf;
+            *ref = grown;
+            _ARTAddChild(tree, ref, grown, byte, child);
+            return;
+        }
+        case ART_NODE48: {
+            ARTNode48 *n = (ARTNode48*) node;
+            if (node->nchildren < 48) {
+                u32 slot = 0;
+                while (n->children[slot]) {
+                    slot++;
+                }
+                n->children[slot] = child;
+                n->index[byte] = (u8) (slot + 1);
+                node->nchildren++;
+                return;
+            }
+
+            ARTNode256 *n256 = (ARTNode256*) _ARTAllocNode(tree, ART_NODE256);
+            for (u32 b = 0; b < 256; ++b) {
+                if (n->index[b]) {
+                    n256->children[b] = n->children[n->index[b] - 1];
+                }
+            }
+            n256->hdr.nchildren = node->nchildren;
+            n256->hdr.prefix_len = node->prefix_len;
+            n256->hdr.prefix = node->prefix;
+            n256->hdr.leaf = node->leaf;
+            *ref = n256;
+            _ARTAddChild(tree, ref, &n256->hdr, byte, child);
+            return;
+        }
+        case ART_NODE256: {
+            ARTNode256 *n = (ARTNode256*) node;
+            n->children[byte] = child;
+            node->nchildren++;
+            return;
+        }
+        default: {
+            assert(1 == 0);
+        }
+    }
+}
+
+ARTLeaf *_ARTMakeLeaf(ART *tree, Str key, void *val) {
+    ARTLeaf *leaf = (ARTLeaf*) ArenaAllocAligned(tree->a, sizeof(ARTLeaf), 8);
+    leaf->key = StrPush(tree->a, key);
+    leaf->val = val;
+    tree->len++;
+    tree->max_key_len = MaxU32(tree->max_key_len, key.len);
+    return leaf;
+}
+
+void _ARTPlace(ART *tree, void **ref, ARTNode *node, Str key, u32 depth, void *child, ARTLeaf *leaf) {
+    // hangs leaf below node: as the node's own leaf if the key ends here, or as a child
+    if (key.len == depth) {
+        node->leaf = leaf;
+    }
+    else {
+        _ARTAddChild(tree, ref, node, (u8) key.str[depth], child);
+    }
+}
+
+void ARTInsert(ART *tree, Str key, void *val) {
+    // inserts or overwrites
+    void **ref = &tree->root;
+    u32 depth = 0;
+
+    while (true) {
+        void *ptr = *ref;
+
+        if (ptr == NULL) {
+            *ref = _ARTTagLeaf(_ARTMakeLeaf(tree, key, val));
+            return;
+        }
+
+        if (_ARTIsLeaf(ptr)) {
+            ARTLeaf *existing = _ARTLeaf(ptr);
+            if (StrEqual(existing->key, key)) {
+                existing->val = val;
+                return;
+            }
+
+            // split into a node holding the common part of both keys
+            u32 common = 0;
+            u32 limit = MinU32(existing->key.len, key.len) - depth;
+            while (common < limit && existing->key.str[depth + common] == key.str[depth + common]) {
+                common++;
+            }
+            ARTNode *node = _ARTAllocNode(tree, ART_NODE4);
+            node->prefix = (u8*) existing->key.str + depth;
+            node->prefix_len = common;
+            depth += common;
+
+            ARTLeaf *leaf = _ARTMakeLeaf(tree, key, val);
+            *ref = node;
+            _ARTPlace(tree, ref, node, existing->key, depth, ptr, existing);
+            _ARTPlace(tree, ref, (ARTNode*) *ref, key, depth, _ARTTagLeaf(leaf), leaf);
+            return;
+        }
+
+        ARTNode *node = (ARTNode*) ptr;
+
+        // match the compressed path
+        u32 p = 0;
+        while (p < node->prefix_len && depth + p < key.len && node->prefix[p] == (u8) key.str[depth + p]) {
+            p++;
+        }
+        if (p < node->prefix_len) {
+            // split the prefix: new node with the matched part, old node below it with the rest
+            ARTNode *split = _ARTAllocNode(tree, ART_NODE4);
+            split->prefix = node->prefix;
+            split->prefix_len = p;
+
+            u8 byte = node->prefix[p];
+            node->prefix += p + 1;
+            node->prefix_len -= p + 1;
+
+            *ref = split;
+            _ARTAddChild(tree, ref, split, byte, node);
+
+            ARTLeaf *leaf = _ARTMakeLeaf(tree, key, val);
+            _ARTPlace(tree, ref, split, key, depth + p, _ARTTagLeaf(leaf), leaf);
+            return;
+        }
+        depth += node->prefix_len;
+
+        if (depth == key.len) {
+            if (node->leaf) {
+                node->leaf->val = val;
+            }
+            else {
+                node->leaf = _ARTMakeLeaf(tree, key, val);
+            }
+            return;
+        }
+
+        void **child = _ARTFindChild(node, (u8) key.str[depth]);
+        if (child == NULL) {
+            ARTLeaf *leaf = _ARTMakeLeaf(tree, key, val);
+            _ARTAddChild(tree, ref, node, (u8) key.str[depth], _ARTTagLeaf(leaf));
+            return;
+        }
+        ref = child;
+        depth++;
+    }
+}
+
+ARTLeaf *ARTGetLeaf(ART *tree, Str key) {
+    void *ptr = tree->root;
+    u32 depth = 0;
+
+    while (ptr) {
+        if (_ARTIsLeaf(ptr)) {
+            ARTLeaf *leaf = _ARTLeaf(ptr);
+            return StrEqual(leaf->key, key) ? leaf : NULL;
+        }
+
+        ARTNode *node = (ARTNode*) ptr;
+        if (key.len - depth < node->prefix_len || memcmp(node->prefix, key.str + depth, node->prefix_len) != 0) {
+            return NULL;
+        }
+        depth += node->prefix_len;
+
+        if (depth == key.len) {
+            return node->leaf;
+        }
+        void **child = _ARTFindChild(node, (u8) key.str[depth]);
+        if (child == NULL) {
+            return NULL;
+        }
+        ptr = *child;
+        depth++;
+    }
+    return NULL;
+}
+
+inline
+void *ARTGet(ART *tree, Str key) {
+    ARTLeaf *leaf = ARTGetLeaf(tree, key);
+    return leaf ? leaf->val : NULL;
+}
+
+
+//
+//  ART iteration
+
+
+struct ARTIterFrame {
+    void *ptr;
+    s32 next; // -1: the node's own leaf is due, otherwise the child cursor (slot for node4/16, byte for node48/256)
+};
+
+struct ARTIter {
+    ARTIterFrame *stack;
+    u32 depth;
+    Str hi;          // exclusive upper bound, if has_hi
+    bool has_hi;
+    Str prefix;      // required prefix, if has_prefix
+    bool has_prefix;
+
+    void _Push(void *ptr, s32 next) {
+        stack[depth].ptr = ptr;
+        stack[depth].next = next;
+        depth++;
+    }
+    void *_NextChild(ARTNode *node, s32 *cursor) {
+        switch (node->type) {
+            case ART_NODE4: {
+                ARTNode4 *n = (ARTNode4*) node;
+                return (*cursor < node->nchildren) ? n->children[(*cursor)++] : NULL;
+            }
+            case ART_NODE16: {
+                ARTNode16 *n = (ARTNode16*) node;
+                return (*cursor < node->nchildren) ? n->children[(*cursor)++] : NULL;
+            }
+            case ART_NODE48: {
+                ARTNode48 *n = (ARTNode48*) node;
+                while (*cursor < 256) {
+                    u8 slot = n->index[(*cursor)++];
+                    if (slot) {
+                        return n->children[slot - 1];
+                    }
+                }
+                return NULL;
+            }
+            case ART_NODE256: {
+                ARTNode256 *n = (ARTNode256*) node;
+                while (*cursor < 256) {
+                    void *child = n->children[(*cursor)++];
+                    if (child) {
+                        return child;
+                    }
+                }
+                return NULL;
+            }
+            default: {
+                return NULL;
+            }
+        }
+    }
+    ARTLeaf *_Check(ARTLeaf *leaf) {
+        // the first key past the bounds ends the iteration
+        bool past = (has_hi && _ARTCompare(leaf->key, hi) >= 0);
+        past = past || (has_prefix && (leaf->key.len < prefix.len || memcmp(leaf->key.str, prefix.str, prefix.len) != 0));
+        if (past) {
+            depth = 0;
+            return NULL;
+        }
+        return leaf;
+    }
+    ARTLeaf *Next() {
+        while (depth > 0) {
+            ARTIterFrame *frame = stack + depth - 1;
+
+            if (_ARTIsLeaf(frame->ptr)) {
+                depth--;
+                return _Check(_ARTLeaf(frame->ptr));
+            }
+
+            ARTNode *node = (ARTNode*) frame->ptr;
+            if (frame->next == -1) {
+                frame->next = 0;
+                if (node->leaf) {
+                    return _Check(node->leaf);
+                }
+            }
+
+            void *child = _NextChild(node, &frame->next);
+            if (child == NULL) {
+                depth--;
+            }
+            else {
+                _Push(child, -1);
+            }
+        }
+        return NULL;
+    }
+};
+
+s32 _ARTCursorAfter(ARTNode *node, u8 byte) {
+    // child cursor of the first child above byte
+    if (node->type == ART_NODE4 || node->type == ART_NODE16) {
+        u8 *keys = (node->type == ART_NODE4) ? ((ARTNode4*) node)->keys : ((ARTNode16*) node)->keys;
+        s32 at = 0;
+        while (at < node->nchildren && keys[at] <= byte) {
+            at++;
+        }
+        return at;
+    }
+    return (s32) byte + 1;
+}
+
+ARTIter ARTIterRange(MArena *a_dest, ART *tree, Str lo, Str hi = Str {}) {
+    // iterates keys k with lo <= k < hi, an empty hi is unbounded
+    ARTIter iter = {};
+    iter.stack = (ARTIterFrame*) ArenaAlloc(a_dest, sizeof(ARTIterFrame) * (tree->max_key_len + 2), false);
+    iter.hi = hi;
+    iter.has_hi = (hi.len > 0);
+
+    // seek: walk down along lo, leaving frames that resume right after lo's path at every level
+    void *ptr = tree->root;
+    u32 depth = 0;
+    while (ptr) {
+        if (_ARTIsLeaf(ptr)) {
+            if (_ARTCompare(_ARTLeaf(ptr)->key, lo) >= 0) {
+                iter._Push(ptr, -1);
+            }
+            break;
+        }
+
+        ARTNode *node = (ARTNode*) ptr;
+        u32 cmp_len = MinU32(node->prefix_len, lo.len - depth);
+        s32 cmp = memcmp(node->prefix, lo.str + depth, cmp_len);
+        if (cmp > 0 || (cmp == 0 && cmp_len < node->prefix_len)) {
+            // the whole subtree sorts after lo
+            iter._Push(ptr, -1);
+            break;
+        }
+        if (cmp < 0) {
+            // the whole subtree sorts before lo
+            break;
+        }
+        depth += node->prefix_len;
+
+        if (depth == lo.len) {
+            iter._Push(ptr, -1);
+            break;
+        }
+
+        // the node's own leaf is a proper prefix of lo, so it sorts before it
+        u8 byte = (u8) lo.str[depth];
+        iter._Push(ptr, _ARTCursorAfter(node, byte));
+        void **child = _ARTFindChild(node, byte);
+        ptr = child ? *child : NULL;
+        depth++;
+    }
+    return iter;
+}
+
+inline
+ARTIter ARTIterAll(MArena *a_dest, ART *tree) {
+    return ARTIterRange(a_dest, tree, Str {});
+}
+
+ARTIter ARTIterPrefix(MArena *a_dest, ART *tree, Str prefix) {
+    ARTIter iter = ARTIterRange(a_dest, tree, prefix);
+    iter.prefix = prefix;
+    iter.has_prefix = (prefix.len > 0);
+    return iter;
+}
+
+
+
+//
+//  Flattened trees
+//
+//  Compacts an LList3 tree (descend: first child, next: next sibling) into preorder arrays. A node's subtree is the
+//  index range [idx, idx + size[idx]), its first child sits at idx + 1 and its next sibling at idx + size[idx].
+//  Node payloads are copied into lst, so traversals touch three flat arrays instead of chasing pointers. The copies
+//  keep their (now stale) links; the layout is a snapshot to rebuild when the source tree changes.
+/*
+    FlatTree<Widget> flat = FlattenTree<Widget>(a, root);
+
+    FlatIter iter = FlatChildren(&flat, 0);
+    u32 child;
+    while (iter.Next(&child)) {
+        Widget *w = flat.lst + child;
+    }
+*/
+
+
+#define FLAT_NO_PARENT 0xFFFFFFFF
+
+
+template<typename T>
+struct FlatTree {
+    T *lst;
+    u32 *parent;
+    u32 *size;  // subtree node count, including the node itself
+    u32 len;
+
+    bool IsAncestor(u32 anc, u32 idx) {
+        return anc <= idx && idx < anc + size[anc];
+    }
+};
+
+struct FlatIter {
+    u32 *size;
+    u32 at;
+    u32 end;
+    bool skip_subtrees;
+
+    bool Next(u32 *idx) {
+        if (at >= end) {
+            return false;
+        }
+        *idx = at;
+        at += skip_subtrees ? size[at] : 1;
+        return true;
+    }
+};
+
+u32 _FlattenWalk(LList3 *root, LList3 **dest, u32 *parent) {
+    // preorder over root and its siblings; counts only when dest is NULL
+    struct Visit {
+        LList3 *node;
+        u32 parent;
+    };
+    u32 cap = 64;
+    u32 top = 0;
+    Visit *stack = (Visit*) malloc(sizeof(Visit) * cap);
+
+    u32 cnt = 0;
+    if (root) {
+        stack[top++] = Visit { root, FLAT_NO_PARENT };
+    }
+    while (top) {
+        Visit v = stack[--top];
+        if (dest) {
+            dest[cnt] = v.node;
+            parent[cnt] = v.parent;
+        }
+        if (top + 2 > cap) {
+            cap *= 2;
+            stack = (Visit*) realloc(stack, sizeof(Visit) * cap);
+        }
+        // the sibling resumes after the whole subtree
+        if (v.node->next) {
+            stack[top++] = Visit { v.node->next, v.parent };
+        }
+        if (v.node->descend) {
+            stack[top++] = Visit { v.node->descend, cnt };
+        }
+        cnt++;
+    }
+    free(stack);
+    return cnt;
+}
+
+template<typename T>
+FlatTree<T> FlattenTree(MArena *a_dest, void *root) {
+    // T must start with an LList3; root's siblings become further roots
+    FlatTree<T> tree = {};
+    tree.len = _FlattenWalk((LList3*) root, NULL, NULL);
+
+    tree.lst = (T*) ArenaAlloc(a_dest, sizeof(T) * tree.len, false);
+    tree.parent = (u32*) ArenaAlloc(a_dest, sizeof(u32) * tree.len, false);
+    tree.size = (u32*) ArenaAlloc(a_dest, sizeof(u32) * tree.len, false);
+
+    LList3 **nodes = (LList3**) malloc(sizeof(LList3*) * MaxU32(tree.len, 1));
+    _FlattenWalk((LList3*) root, nodes, tree.parent);
+    for (u32 i = 0; i < tree.len; ++i) {
+        tree.lst[i] = *((T*) nodes[i]);
+        tree.size[i] = 1;
+    }
+    free(nodes);
+
+    // children follow their parent in preorder, so a reverse sweep sums complete subtrees
+    for (u32 i = tree.len; i-- > 0;) {
+        if (tree.parent[i] != FLAT_NO_PARENT) {
+            tree.size[tree.parent[i]] += tree.size[i];
+        }
+    }
+    return tree;
+}
+
+template<typename T>
+FlatIter FlatSubtree(FlatTree<T> *tree, u32 idx) {
+    // idx and all its descendants in preorder
+    assert(idx < tree->len);
+    return FlatIter { tree->size, idx, idx + tree->size[idx], false };
+}
+
+template<typename T>
+FlatIter FlatChildren(FlatTree<T> *tree, u32 idx) {
+    assert(idx < tree->len);
+    return FlatIter { tree->size, idx + 1, idx + tree->size[idx], true };
+}
+
+template<typename T>
+FlatIter FlatRoots(FlatTree<T> *tree) {
+    return FlatIter { tree->size, 0, tree->len, true };
+}
+
+
+#endif
@@ -1,5 +1,6 @@
 #include <cstdio>
 #include <cassert>
+#include <thread>
 #include "src/baselayer.h"
 
 
@@ -163,6 +164,779 @@ void TestSorting() {
 }
 
 
+List<u32> _RandomSortedListU32(MArena *a, u32 len, u32 max) {
+    List<u32> lst = InitList<u32>(a, len);
+    for (u32 i = 0; i < len; ++i) {
+        lst.Add(RandMinMaxU(0, max));
+    }
+    // insertion sort, lists are up to a few thousand elements
+    for (u32 i = 1; i < lst.len; ++i) {
+        u32 v = lst.lst[i];
+        u32 j = i;
+        while (j > 0 && lst.lst[j - 1] > v) {
+            lst.lst[j] = lst.lst[j - 1];
+            --j;
+        }
+        lst.lst[j] = v;
+    }
+    return lst;
+}
+bool _ContainsU32(List<u32> lst, u32 val) {
+    for (u32 i = 0; i < lst.len; ++i) {
+        if (lst.lst[i] == val) {
+            return true;
+        }
+    }
+    return false;
+}
+void TestSetAlgebra() {
+    printf("\nTestSetAlgebra\n");
+
+    MArena _a = ArenaCreate();
+    MArena *a = &_a;
+    RandInit();
+
+    u32 sizes[][2] = { { 0, 10 }, { 1, 1 }, { 7, 9 }, { 100, 300 }, { 1000, 1000 }, { 20, 3000 }, { 3000, 5 } };
+    for (u32 t = 0; t < sizeof(sizes) / sizeof(sizes[0]); ++t) {
+        for (u32 rep = 0; rep < 20; ++rep) {
+            u32 max = RandMinMaxU(1, 2 * (sizes[t][0] + sizes[t][1]) + 1);
+            List<u32> la = _RandomSortedListU32(a, sizes[t][0], max);
+            List<u32> lb = _RandomSortedListU32(a, sizes[t][1], max);
+
+            List<u32> isect = SetIntersectionU32(a, la, lb);
+            List<u32> unio = SetUnionU32(a, la, lb);
+            List<u32> diff = SetDifferenceU32(a, la, lb);
+
+            // outputs are strictly increasing
+            for (u32 i = 1; i < isect.len; ++i) { assert(isect.lst[i - 1] < isect.lst[i]); }
+            for (u32 i = 1; i < unio.len; ++i) { assert(unio.lst[i - 1] < unio.lst[i]); }
+            for (u32 i = 1; i < diff.len; ++i) { assert(diff.lst[i - 1] < diff.lst[i]); }
+
+            // membership against the definitions
+            for (u32 v = 0; v <= max; ++v) {
+                bool in_a = _ContainsU32(la, v);
+                bool in_b = _ContainsU32(lb, v);
+                assert(_ContainsU32(isect, v) == (in_a && in_b));
+                assert(_ContainsU32(unio, v) == (in_a || in_b));
+                assert(_ContainsU32(diff, v) == (in_a && !in_b));
+            }
+            ArenaClear(a);
+        }
+    }
+    printf("intersection, union, difference OK\n");
+}
+
+
+void TestPackedU32() {
+    printf("\nTestPackedU32\n");
+
+    MArena _a = ArenaCreate();
+    MArena *a = &_a;
+    RandInit();
+
+    // dense ids with mostly small gaps, some duplicates and a few large jumps
+    u32 n = 100000 + RandIntMax(PACKED_BLOCK_LEN);
+    List<u32> ids = InitList<u32>(a, n);
+    u32 val = RandIntMax(1000);
+    for (u32 i = 0; i < n; ++i) {
+        val += (RandIntMax(100) == 1) ? RandIntMax(1 << 20) : RandIntMax(20) - 1;
+        ids.Add(val);
+    }
+
+    PackCodec codecs[] = { PACK_STREAMVBYTE, PACK_BITPACK };
+    for (u32 c = 0; c < 2; ++c) {
+        PackedU32 packed = PackU32(a, ids, codecs[c]);
+        printf("%s: %u values, %.2f bytes/value\n", c == 0 ? "streamvbyte" : "bitpack", n, (f32) packed.SizeBytes() / n);
+        assert(packed.SizeBytes() < n * (c == 0 ? 2 : 3)); // bit-packing pays for the widest delta in a block
+
+        List<u32> unpacked = UnpackU32(a, &packed);
+        assert(unpacked.len == n);
+        assert(memcmp(unpacked.lst, ids.lst, sizeof(u32) * n) == 0);
+
+        PackedIter iter = InitPackedIter(&packed);
+        u32 cnt = 0;
+        while (iter.Next(&val)) {
+            assert(val == ids.lst[cnt]);
+            cnt++;
+        }
+        assert(cnt == n);
+
+        // skip to increasing targets, compare against a linear lower bound
+        iter = InitPackedIter(&packed);
+        u32 target = 0;
+        u32 lb = 0;
+        while (true) {
+            target += RandIntMax(3000);
+            while (lb < n && ids.lst[lb] < target) {
+                lb++;
+            }
+            bool found = iter.SkipTo(target, &val);
+            assert(found == (lb < n));
+            if (found == false) {
+                break;
+            }
+            assert(val == ids.lst[lb]);
+            lb++;
+        }
+    }
+
+    // empty and single-value lists
+    List<u32> empty = {};
+    PackedU32 packed = PackU32(a, empty);
+    List<u32> unpacked = UnpackU32(a, &packed);
+    assert(unpacked.len == 0);
+    u32 one = 42;
+    packed = PackU32(a, List<u32> { &one, 1 }, PACK_BITPACK);
+    PackedIter iter = InitPackedIter(&packed);
+    bool skipped = iter.SkipTo(7, &val);
+    assert(skipped && val == 42);
+    bool more = iter.Next(&val);
+    assert(more == false);
+
+    printf("roundtrip, iteration and skipping OK\n");
+    ArenaDestroy(a);
+}
+
+
+void TestHeap() {
+    printf("\nTestHeap\n");
+
+    MArena _a = ArenaCreate();
+    MArena *a = &_a;
+    RandInit();
+
+    // push / pop yields ascending order
+    u32 cnt = 1000;
+    Heap<u32> heap = InitHeap<u32>(a, cnt);
+    for (u32 i = 0; i < cnt; ++i) {
+        heap.Push(RandMinMaxU(0, 500));
+    }
+    u32 prev = 0;
+    while (heap.len) {
+        u32 v = heap.Pop();
+        assert(v >= prev);
+        prev = v;
+    }
+
+    // bulk heapify, binary heap variant
+    List<u32> vals = InitList<u32>(a, cnt);
+    for (u32 i = 0; i < cnt; ++i) {
+        vals.Add(RandMinMaxU(0, 100000));
+    }
+    Heap<u32, 2> heap2 = InitHeap<u32, 2>(a, cnt);
+    heap2.Heapify(vals.lst, vals.len);
+    prev = 0;
+    while (heap2.len) {
+        u32 v = heap2.Pop();
+        assert(v >= prev);
+        prev = v;
+    }
+
+    // indexed heap with decrease-key
+    u32 nids = 200;
+    Heap<f32> iheap = InitHeapIndexed<f32>(a, nids, nids);
+    f32 *keys = (f32*) ArenaAlloc(a, sizeof(f32) * nids);
+    for (u32 id = 0; id < nids; ++id) {
+        keys[id] = 100 + Rand01_f32() * 100;
+        iheap.Push(keys[id], id);
+    }
+    for (u32 i = 0; i < nids; ++i) {
+        u32 id = RandMinMaxU(0, nids - 1);
+        keys[id] -= Rand01_f32() * 150;
+        iheap.DecreaseKey(id, keys[id]);
+    }
+    f32 prevf = -1000;
+    u32 popped = 0;
+    while (iheap.len) {
+        u32 id;
+        f32 v = iheap.Pop(&id);
+        assert(v == keys[id]);
+        assert(v >= prevf);
+        assert(iheap.Contains(id) == false);
+        prevf = v;
+        popped++;
+    }
+    assert(popped == nids);
+
+    // heapify on an indexed heap, ids default to the element positions
+    iheap.Heapify(keys, nids);
+    iheap.DecreaseKey(nids - 1, -1000);
+    u32 top;
+    iheap.Pop(&top);
+    assert(top == nids - 1 && iheap.Contains(0) && iheap.len == nids - 1);
+    printf("push/pop, heapify, decrease-key OK\n");
+}
+
+
+void TestQueueSPSC() {
+    printf("\nTestQueueSPSC\n");
+
+    MArena _a = ArenaCreate();
+    MArena *a = &_a;
+
+    // single-threaded wrap-around and batching
+    QueueSPSC<u32> *q = InitQueueSPSC<u32>(a, 8);
+    u32 batch[16];
+    for (u32 i = 0; i < 16; ++i) {
+        batch[i] = i;
+    }
+    u32 pushed = q->PushBatch(batch, 16);
+    bool pushed_full = q->Push(99);
+    assert(pushed == 8 && pushed_full == false);
+    u32 v;
+    for (u32 i = 0; i < 5; ++i) {
+        bool popped = q->Pop(&v);
+        assert(popped && v == i);
+    }
+    pushed = q->PushBatch(batch + 8, 8);
+    assert(pushed == 5);
+    u32 out[16];
+    u32 popped = q->PopBatch(out, 16);
+    assert(popped == 8);
+    assert(out[0] == 5 && out[2] == 7 && out[3] == 8 && out[7] == 12);
+    bool popped_empty = q->Pop(&v);
+    assert(popped_empty == false);
+
+    // producer / consumer threads
+    u32 cnt = 1000000;
+    QueueSPSC<u32> *q2 = InitQueueSPSC<u32>(a, 1024);
+    std::thread producer([q2, cnt]() {
+        u32 buff[32];
+        u32 next = 1;
+        while (next <= cnt) {
+            if (next % 3) {
+                while (q2->Push(next) == false) { std::this_thread::yield(); }
+                next++;
+            }
+            else {
+                u32 n = MinU32(32, cnt - next + 1);
+                for (u32 i = 0; i < n; ++i) {
+                    buff[i] = next + i;
+                }
+                u32 pushed = 0;
+                while (pushed < n) {
+                    u32 k = q2->PushBatch(buff + pushed, n - pushed);
+                    if (k == 0) {
+                        std::this_thread::yield();
+                    }
+                    pushed += k;
+                }
+                next += n;
+            }
+        }
+    });
+    u32 expect = 1;
+    u32 buff[64];
+    while (expect <= cnt) {
+        u32 n = q2->PopBatch(buff, 64);
+        for (u32 i = 0; i < n; ++i) {
+            assert(buff[i] == expect);
+            expect++;
+        }
+        if (n == 0) {
+            std::this_thread::yield();
+        }
+    }
+    producer.join();
+    assert(q2->Len() == 0);
+
+    printf("wrap-around, batching, %u items across threads OK\n", cnt);
+    ArenaDestroy(a);
+}
+
+
+void TestQueueMPMC() {
+    printf("\nTestQueueMPMC\n");
+
+    MArena _a = ArenaCreate();
+    MArena *a = &_a;
+
+    // single-threaded fill / drain
+    QueueMPMC<u32> *q = InitQueueMPMC<u32>(a, 4);
+    for (u32 i = 0; i < 4; ++i) {
+        bool pushed = q->TryPush(i + 1);
+        assert(pushed);
+    }
+    bool pushed_full = q->TryPush(5);
+    assert(pushed_full == false);
+    u32 v;
+    for (u32 i = 0; i < 4; ++i) {
+        bool popped = q->TryPop(&v);
+        assert(popped && v == i + 1);
+    }
+    bool popped_empty = q->TryPop(&v);
+    assert(popped_empty == false);
+
+    // 4 producers, 4 consumers, every value delivered exactly once, both modes
+    for (u32 mode = 0; mode < 2; ++mode) {
+        bool blocking = (mode == 1);
+        u32 nthreads = 4;
+        u32 per_producer = 50000;
+        u32 total = nthreads * per_producer;
+
+        QueueMPMC<u32> *q2 = InitQueueMPMC<u32>(a, 256, blocking);
+        std::atomic<u32> *seen = (std::atomic<u32>*) ArenaAlloc(a, sizeof(std::atomic<u32>) * total);
+        std::atomic<u32> consumed(0);
+        std::thread threads[8];
+
+        for (u32 t = 0; t < nthreads; ++t) {
+            threads[t] = std::thread([=]() {
+                for (u32 i = 0; i < per_producer; ++i) {
+                    u32 val = t * per_producer + i;
+                    if (blocking) {
+                        q2->Push(val);
+                    }
+                    else {
+                        while (q2->TryPush(val) == false) { std::this_thread::yield(); }
+                    }
+                }
+            });
+        }
+        for (u32 t = 0; t < nthreads; ++t) {
+            threads[nthreads + t] = std::thread([=, &consumed]() {
+                for (u32 i = 0; i < per_producer; ++i) {
+                    u32 val;
+                    if (blocking) {
+                        val = q2->Pop();
+                    }
+                    else {
+                        while (q2->TryPop(&val) == false) { std::this_thread::yield(); }
+                    }
+                    assert(val < total);
+                    seen[val].fetch_add(1);
+                    consumed.fetch_add(1);
+                }
+            });
+        }
+        for (u32 t = 0; t < 2 * nthreads; ++t) {
+            threads[t].join();
+        }
+        assert(consumed.load() == total);
+        for (u32 i = 0; i < total; ++i) {
+            assert(seen[i].load() == 1);
+        }
+        printf("%s: %u items through 4:4 threads OK\n", blocking ? "blocking" : "non-blocking", total);
+    }
+    ArenaDestroy(a);
+}
+
+
+void TestConcurrentMap() {
+    printf("\nTestConcurrentMap\n");
+
+    MArena _a = ArenaCreate();
+    MArena *a = &_a;
+
+    // few shards with tiny tables, so that shards grow while readers are probing them
+    ConcurrentMap map = InitConcurrentMap(a, 4, 8);
+    u32 nwriters = 4;
+    u32 nreaders = 2;
+    u32 per_writer = 20000;
+    std::atomic<u32> done_writers { 0 };
+    std::atomic<u32> bad_reads { 0 };
+
+    // writer w owns keys w + 1 + i * nwriters: puts each with key * 3, removes every fourth, overwrites every fifth
+    std::thread threads[6];
+    for (u32 w = 0; w < nwriters; ++w) {
+        threads[w] = std::thread([&map, &done_writers, w, nwriters, per_writer]() {
+            for (u32 i = 0; i < per_writer; ++i) {
+                u64 key = w + 1 + (u64) i * nwriters;
+                MapPut(&map, key, key * 3);
+                if (i % 4 == 3) {
+                    u64 old = w + 1 + (u64) (i - 2) * nwriters;
+                    s64 removed = MapRemove(&map, old);
+                    assert(removed != -1);
+                }
+                if (i % 5 == 4) {
+                    MapPut(&map, key, key * 3);
+                }
+                if (i % 64 == 0) {
+                    std::this_thread::yield();
+                }
+            }
+            done_writers.fetch_add(1);
+        });
+    }
+    // readers only ever see absent or the one value a key gets
+    for (u32 r = 0; r < nreaders; ++r) {
+        threads[nwriters + r] = std::thread([&map, &done_writers, &bad_reads, nwriters, per_writer]() {
+            u64 x = 12345;
+            while (done_writers.load() < nwriters) {
+                for (u32 i = 0; i < 256; ++i) {
+                    x = x * 6364136223846793005ull + 1442695040888963407ull;
+                    u64 key = 1 + (x >> 33) % (nwriters * per_writer);
+                    u64 val = MapGet(&map, key);
+                    if (val != 0 && val != key * 3) {
+                        bad_reads.fetch_add(1);
+                    }
+                }
+                std::this_thread::yield();
+            }
+        });
+    }
+    for (u32 i = 0; i < nwriters + nreaders; ++i) {
+        threads[i].join();
+    }
+    assert(bad_reads.load() == 0);
+
+    // final state: every fourth key of each writer is gone
+    u32 nlive = 0;
+    for (u32 w = 0; w < nwriters; ++w) {
+        for (u32 i = 0; i < per_writer; ++i) {
+            u64 key = w + 1 + (u64) i * nwriters;
+            bool removed = (i % 4 == 1) && (i + 2 < per_writer);
+            assert(MapGet(&map, key) == (removed ? 0 : key * 3));
+            nlive += !removed;
+        }
+    }
+    assert(ConcurrentMapLen(&map) == nlive);
+    s64 missing = MapRemove(&map, nwriters * per_writer + 1);
+    assert(missing == -1 && MapGet(&map, (u64) 0) == 0);
+
+    ConcurrentMapFree(&map);
+    printf("%u writers, %u readers: no torn reads, final state OK\n", nwriters, nreaders);
+    ArenaDestroy(a);
+}
+
+
+void TestBucketArray() {
+    printf("\nTestBucketArray\n");
+
+    MArena _a = ArenaCreate();
+    MArena *a = &_a;
+
+    // arena-backed, pointers stay put while growing
+    u32 cnt = 10000;
+    BucketArray<PoolTestEntity> arr = InitBucketArray<PoolTestEntity>(a, 100);
+    assert(arr.ChunkLen() == 128);
+    PoolTestEntity **ptrs = (PoolTestEntity**) ArenaAlloc(a, sizeof(PoolTestEntity*) * cnt);
+    for (u32 i = 0; i < cnt; ++i) {
+        ptrs[i] = arr.Add({ (f32) i, 0, 0 });
+    }
+    for (u32 i = 0; i < cnt; ++i) {
+        assert(arr.GetPtr(i) == ptrs[i]);
+        assert(ptrs[i]->a == (f32) i);
+    }
+
+    // chunk-wise iteration
+    u32 visited = 0;
+    for (u32 c = 0; c < arr.ChunkCount(); ++c) {
+        u32 n;
+        PoolTestEntity *chunk = arr.GetChunk(c, &n);
+        for (u32 i = 0; i < n; ++i) {
+            assert(chunk[i].a == (f32) visited);
+            visited++;
+        }
+    }
+    assert(visited == cnt);
+
+    // pool-backed, runs dry when the pool does
+    MPool pool = PoolCreate(a, 1024, 4);
+    BucketArray<u32> arr2 = InitBucketArray<u32>(a, &pool);
+    u32 per_chunk = arr2.ChunkLen();
+    assert(per_chunk * sizeof(u32) <= pool.block_size);
+    for (u32 i = 0; i < 4 * per_chunk; ++i) {
+        u32 *added = arr2.Add(i);
+        assert(added != NULL);
+    }
+    u32 *dry = arr2.Add(0);
+    assert(dry == NULL);
+    assert(pool.occupancy == 4);
+    arr2.Release();
+    assert(pool.occupancy == 0);
+
+    printf("stable pointers, chunk iteration, pool chunks OK\n");
+    ArenaDestroy(a);
+}
+
+
+void TestSlotMap() {
+    printf("\nTestSlotMap\n");
+
+    MArena _a = ArenaCreate();
+    MArena *a = &_a;
+    RandInit();
+
+    u32 cap = 64;
+    SlotMap<u32> map = InitSlotMap<u32>(a, cap);
+    SlotKey keys[64];
+    u32 vals[64];
+    u32 nlive = 0;
+    SlotKey stale[256];
+    u32 nstale = 0;
+
+    for (u32 iter = 0; iter < 20000; ++iter) {
+        if (nlive < cap && (nlive == 0 || RandMinMaxU(0, 2))) {
+            u32 val = RandMinMaxU(0, 1000000);
+            SlotKey key = map.Insert(val);
+            assert(key.gen != 0);
+            keys[nlive] = key;
+            vals[nlive] = val;
+            nlive++;
+        }
+        else {
+            u32 r = RandIntMax(nlive) - 1;
+            bool removed = map.Remove(keys[r]);
+            bool again = map.Remove(keys[r]);
+            assert(removed && again == false);
+            stale[nstale++ % 256] = keys[r];
+            keys[r] = keys[nlive - 1];
+            vals[r] = vals[nlive - 1];
+            nlive--;
+        }
+        assert(map.len == nlive);
+    }
+    if (nlive == cap) {
+        SlotKey full = map.Insert(0);
+        assert(full.gen == 0);
+    }
+
+    // live keys resolve, stale keys never do
+    for (u32 i = 0; i < nlive; ++i) {
+        assert(*map.Get(keys[i]) == vals[i]);
+    }
+    for (u32 i = 0; i < MinU32(nstale, 256); ++i) {
+        assert(map.Get(stale[i]) == NULL);
+    }
+
+    // dense iteration covers exactly the live values
+    u64 sum_dense = 0;
+    u64 sum_live = 0;
+    for (u32 i = 0; i < map.len; ++i) {
+        sum_dense += map.lst[i];
+        assert(map.Get(map.KeyAt(i)) == map.lst + i);
+    }
+    for (u32 i = 0; i < nlive; ++i) {
+        sum_live += vals[i];
+    }
+    assert(sum_dense == sum_live);
+
+    map.Clear();
+    assert(map.len == 0 && map.Get(keys[0]) == NULL);
+    printf("insert/remove, stale keys, dense iteration OK\n");
+    ArenaDestroy(a);
+}
+
+
+int _ARTCompareQsort(const void *a, const void *b) {
+    return _ARTCompare(*(Str*) a, *(Str*) b);
+}
+
+void TestART() {
+    printf("\nTestART\n");
+
+    MArena _a = ArenaCreate();
+    MArena *a = &_a;
+    RandInit();
+
+    // random keys: a low-entropy tail for deep shared paths, a full-range first byte to grow node256
+    u32 nkeys = 20000;
+    Str *keys = (Str*) ArenaAlloc(a, sizeof(Str) * nkeys);
+    for (u32 i = 0; i < nkeys; ++i) {
+        u32 len = RandIntMax(12);
+        Str key = StrAlloc(a, len);
+        for (u32 j = 0; j < len; ++j) {
+            key.str[j] = (j == 0) ? (char) (RandIntMax(256) - 1) : (char) ('a' + RandIntMax(3) - 1);
+        }
+        keys[i] = key;
+    }
+
+    ART tree = InitART(a);
+    for (u32 i = 0; i < nkeys; ++i) {
+        ARTInsert(&tree, keys[i], (void*) (u64) (i + 1));
+    }
+
+    // reference: sorted, unique, last write wins
+    qsort(keys, nkeys, sizeof(Str), _ARTCompareQsort);
+    u32 nuniq = 0;
+    for (u32 i = 0; i < nkeys; ++i) {
+        if (nuniq == 0 || StrEqual(keys[nuniq - 1], keys[i]) == false) {
+            keys[nuniq++] = keys[i];
+        }
+    }
+    assert(tree.len == nuniq);
+    for (u32 i = 0; i < nuniq; ++i) {
+        assert(ARTGetLeaf(&tree, keys[i]) != NULL);
+    }
+    assert(ARTGet(&tree, StrL("zzzzzzzzzzzzz")) == NULL);
+
+    // ordered iteration
+    ARTIter iter = ARTIterAll(a, &tree);
+    u32 cnt = 0;
+    while (ARTLeaf *leaf = iter.Next()) {
+        assert(StrEqual(leaf->key, keys[cnt]));
+        cnt++;
+    }
+    assert(cnt == nuniq);
+
+    // ranges
+    for (u32 t = 0; t < 100; ++t) {
+        Str lo = keys[RandIntMax(nuniq) - 1];
+        Str hi = keys[RandIntMax(nuniq) - 1];
+        if (_ARTCompare(lo, hi) > 0) {
+            Str tmp = lo; lo = hi; hi = tmp;
+        }
+        lo.len = RandIntMax(lo.len + 1) - 1; // also seek to keys not in the tree
+
+        u32 expect = 0;
+        u32 first = nuniq;
+        for (u32 i = 0; i < nuniq; ++i) {
+            if (_ARTCompare(keys[i], lo) >= 0 && (hi.len == 0 || _ARTCompare(keys[i], hi) < 0)) {
+                first = MinU32(first, i);
+                expect++;
+            }
+        }
+        iter = ARTIterRange(a, &tree, lo, hi);
+        cnt = 0;
+        while (ARTLeaf *leaf = iter.Next()) {
+            assert(StrEqual(leaf->key, keys[first + cnt]));
+            cnt++;
+        }
+        assert(cnt == expect);
+    }
+
+    // prefixes
+    for (u32 t = 0; t < 100; ++t) {
+        Str prefix = keys[RandIntMax(nuniq) - 1];
+        prefix.len = RandIntMax(prefix.len + 1) - 1;
+
+        u32 expect = 0;
+        for (u32 i = 0; i < nuniq; ++i) {
+            expect += (keys[i].len >= prefix.len && memcmp(keys[i].str, prefix.str, prefix.len) == 0);
+        }
+        iter = ARTIterPrefix(a, &tree, prefix);
+        cnt = 0;
+        while (ARTLeaf *leaf = iter.Next()) {
+            assert(leaf->key.len >= prefix.len && memcmp(leaf->key.str, prefix.str, prefix.len) == 0);
+            cnt++;
+        }
+        assert(cnt == expect);
+    }
+
+    // file paths
+    ART paths = InitART(a);
+    ARTInsert(&paths, StrL("src/hash.h"), NULL);
+    ARTInsert(&paths, StrL("src/base.h"), NULL);
+    ARTInsert(&paths, StrL("src"), NULL);
+    ARTInsert(&paths, StrL("main.cpp"), NULL);
+    ARTInsert(&paths, StrL("src/tree.h"), NULL);
+    iter = ARTIterPrefix(a, &paths, StrL("src/"));
+    const char *expect_paths[] = { "src/base.h", "src/hash.h", "src/tree.h" };
+    for (u32 i = 0; i < 3; ++i) {
+        ARTLeaf *leaf = iter.Next();
+        assert(leaf && StrEqual(leaf->key, expect_paths[i]));
+    }
+    ARTLeaf *done = iter.Next();
+    assert(done == NULL);
+
+    printf("insert/get, ordered, range and prefix iteration OK (%u keys)\n", nuniq);
+    ArenaDestroy(a);
+}
+
+
+struct TestTreeNode {
+    LList3 links;
+    u32 id;
+    u32 parent_id;
+};
+
+void TestFlatTree() {
+    printf("\nTestFlatTree\n");
+
+    MArena _a = ArenaCreate();
+    MArena *a = &_a;
+    RandInit();
+
+    // random forest: each new node goes below a random existing node or becomes a new root
+    u32 cnt = 5000;
+    TestTreeNode *nodes = (TestTreeNode*) ArenaAlloc(a, sizeof(TestTreeNode) * cnt);
+    u32 *nchildren = (u32*) ArenaAlloc(a, sizeof(u32) * cnt);
+    TestTreeNode *last_root = nodes;
+    nodes[0].parent_id = FLAT_NO_PARENT;
+    for (u32 i = 1; i < cnt; ++i) {
+        nodes[i].id = i;
+        if (RandIntMax(50) == 1) {
+            nodes[i].parent_id = FLAT_NO_PARENT;
+            last_root->links.next = &nodes[i].links;
+            last_root = nodes + i;
+        }
+        else {
+            u32 p = RandIntMax(i) - 1;
+            nodes[i].parent_id = p;
+            nodes[i].links.next = nodes[p].links.descend;
+            nodes[p].links.descend = &nodes[i].links;
+            nchildren[p]++;
+        }
+    }
+
+    FlatTree<TestTreeNode> flat = FlattenTree<TestTreeNode>(a, nodes);
+    assert(flat.len == cnt);
+
+    // flat index of every original node, parents agree with the source
+    u32 *flat_idx = (u32*) ArenaAlloc(a, sizeof(u32) * cnt);
+    for (u32 i = 0; i < flat.len; ++i) {
+        flat_idx[flat.lst[i].id] = i;
+    }
+    for (u32 i = 0; i < flat.len; ++i) {
+        u32 pid = flat.lst[i].parent_id;
+        if (pid == FLAT_NO_PARENT) {
+            assert(flat.parent[i] == FLAT_NO_PARENT);
+        }
+        else {
+            assert(flat.parent[i] == flat_idx[pid]);
+            assert(flat.parent[i] < i && flat.IsAncestor(flat.parent[i], i));
+        }
+    }
+
+    // children iterate in sibling order, subtrees contain exactly the nodes whose parent chain hits the root
+    for (u32 t = 0; t < 200; ++t) {
+        u32 idx = RandIntMax(cnt) - 1;
+
+        FlatIter iter = FlatChildren(&flat, idx);
+        u32 child;
+        u32 nkids = 0;
+        LList3 *src = nodes[flat.lst[idx].id].links.descend;
+        while (iter.Next(&child)) {
+            assert(&nodes[flat.lst[child].id].links == src);
+            src = src->next;
+            nkids++;
+        }
+        assert(src == NULL && nkids == nchildren[flat.lst[idx].id]);
+
+        u32 nsub = 0;
+        for (u32 i = 0; i < flat.len; ++i) {
+            u32 up = i;
+            while (up != FLAT_NO_PARENT && up != idx) {
+                up = flat.parent[up];
+            }
+            nsub += (up == idx);
+        }
+        iter = FlatSubtree(&flat, idx);
+        u32 sub;
+        u32 nit = 0;
+        while (iter.Next(&sub)) {
+            assert(flat.IsAncestor(idx, sub));
+            nit++;
+        }
+        assert(nit == nsub && nsub == flat.size[idx]);
+    }
+
+    FlatIter roots = FlatRoots(&flat);
+    u32 root;
+    u32 nroots = 0;
+    u32 total = 0;
+    while (roots.Next(&root)) {
+        assert(flat.parent[root] == FLAT_NO_PARENT);
+        total += flat.size[root];
+        nroots++;
+    }
+    assert(total == cnt);
+
+    printf("flattened %u nodes in %u trees, parents, children and subtrees OK\n", cnt, nroots);
+    ArenaDestroy(a);
+}
+
+
 void TestStringHelpers() {
     printf("\nTestStringHelpers\n");
 
@@ -266,6 +1040,443 @@ void TestStrBuffer() {
 }
 
 
+void TestFilters() {
+    printf("\nTestFilters\n");
+
+    MArena _a = ArenaCreate();
+    MArena *a = &_a;
+    RandInit();
+
+    u32 nkeys = 100000;
+    u32 nprobes = 200000;
+    u64 *keys = (u64*) ArenaAlloc(a, sizeof(u64) * nkeys);
+    for (u32 i = 0; i < nkeys; ++i) {
+        keys[i] = 2 * RandMinMax64(1, 1ull << 40); // even keys are members, odd probes are not
+    }
+
+    // bloom: no false negatives, fp rate near the expected
+    u32 bpk[] = { 8, 12, 16 };
+    f32 max_fp[] = { 0.04f, 0.012f, 0.004f };
+    for (u32 t = 0; t < 3; ++t) {
+        BloomFilter bloom = InitBloomFilter(a, nkeys, bpk[t]);
+        for (u32 i = 0; i < nkeys; ++i) {
+            BloomAdd(&bloom, keys[i]);
+        }
+        for (u32 i = 0; i < nkeys; ++i) {
+            assert(BloomMayContain(&bloom, keys[i]));
+        }
+        u32 fps = 0;
+        for (u32 i = 0; i < nprobes; ++i) {
+            fps += BloomMayContain(&bloom, 2 * RandMinMax64(1, 1ull << 40) + 1);
+        }
+        f32 fp_rate = (f32) fps / nprobes;
+        printf("bloom %u bits/key: fp rate %.4f\n", bpk[t], fp_rate);
+        assert(fp_rate < max_fp[t]);
+    }
+
+    // cuckoo: add, query, remove
+    CuckooFilter cuckoo = InitCuckooFilter(a, nkeys);
+    for (u32 i = 0; i < nkeys; ++i) {
+        bool added = CuckooAdd(&cuckoo, keys[i]);
+        assert(added);
+    }
+    for (u32 i = 0; i < nkeys; ++i) {
+        assert(CuckooMayContain(&cuckoo, keys[i]));
+    }
+    u32 fps = 0;
+    for (u32 i = 0; i < nprobes; ++i) {
+        fps += CuckooMayContain(&cuckoo, 2 * RandMinMax64(1, 1ull << 40) + 1);
+    }
+    printf("cuckoo: fp rate %.5f, load %.2f\n", (f32) fps / nprobes, (f32) cuckoo.len / (cuckoo.nbuckets * CUCKOO_BUCKET_SIZE));
+    assert(fps < nprobes / 1000);
+    for (u32 i = 0; i < nkeys / 2; ++i) {
+        bool removed = CuckooRemove(&cuckoo, keys[i]);
+        assert(removed);
+    }
+    for (u32 i = nkeys / 2; i < nkeys; ++i) {
+        assert(CuckooMayContain(&cuckoo, keys[i]));
+    }
+    assert(cuckoo.len == nkeys - nkeys / 2);
+
+    // overfill: failing inserts must not lose earlier keys
+    CuckooFilter small = InitCuckooFilter(a, 100);
+    u32 added = 0;
+    while (CuckooAdd(&small, keys[added])) {
+        added++;
+    }
+    for (u32 i = 0; i < added; ++i) {
+        assert(CuckooMayContain(&small, keys[i]));
+    }
+    printf("cuckoo: filled %u of %u entries before failing\n", added, small.nbuckets * CUCKOO_BUCKET_SIZE);
+
+    // in front of a HashMap
+    HashMap map = InitMap(a, 2047);
+    BloomFilter guard = InitBloomFilter(a, 1000, 12);
+    for (u32 i = 0; i < 1000; ++i) {
+        MapPut(&map, keys[i], i + 1);
+        BloomAdd(&guard, keys[i]);
+    }
+    u32 map_lookups = 0;
+    for (u32 i = 0; i < 10000; ++i) {
+        u64 probe = (i < 1000) ? keys[i] : 2 * RandMinMax64(1, 1ull << 40) + 1;
+        u64 val = 0;
+        if (BloomMayContain(&guard, probe)) {
+            map_lookups++;
+            val = MapGet(&map, probe);
+        }
+        assert((i < 1000) == (val == i + 1));
+    }
+    printf("bloom guard: %u map lookups for 10000 queries with 1000 hits\n", map_lookups);
+
+    ArenaDestroy(a);
+}
+
+
+void _TestLRUEvictCount(u64, void *, void *userdata) {
+    (*(u32*) userdata)++;
+}
+void TestLRUCache() {
+    printf("\nTestLRUCache\n");
+
+    MArena _a = ArenaCreate();
+    MArena *a = &_a;
+    RandInit();
+
+    // compare against a reference recency list, keys[0] is the most recent
+    u32 cap = 16;
+    u32 evicted = 0;
+    LRUCache *cache = InitLRUCache(a, cap, 0, _TestLRUEvictCount, &evicted);
+    u64 keys[16];
+    u32 nkeys = 0;
+
+    for (u32 iter = 0; iter < 20000; ++iter) {
+        u64 key = RandMinMaxU(1, 40);
+        u32 at = nkeys;
+        for (u32 i = 0; i < nkeys; ++i) {
+            if (keys[i] == key) {
+                at = i;
+            }
+        }
+
+        if (RandMinMaxU(0, 1)) {
+            void *val = LRUGet(cache, key);
+            if (at == nkeys) {
+                assert(val == NULL);
+                continue;
+            }
+            assert(val == (void*) (key * 10));
+        }
+        else {
+            LRUPut(cache, key, (void*) (key * 10));
+            if (at == nkeys) {
+                at = MinU32(nkeys, cap - 1);
+                nkeys = MinU32(nkeys + 1, cap);
+            }
+        }
+
+        // move to front
+        for (u32 i = at; i > 0; --i) {
+            keys[i] = keys[i - 1];
+        }
+        keys[0] = key;
+
+        assert(cache->len == nkeys);
+        LList2 *node = cache->recent.next;
+        for (u32 i = 0; i < nkeys; ++i) {
+            assert(((LRUEntry*) node)->key == keys[i]);
+            node = node->next;
+        }
+    }
+    assert(cache->evictions == evicted);
+    cache->Print();
+
+    // byte budget
+    LRUCache *cache2 = InitLRUCache(a, 100, 1000);
+    for (u64 key = 1; key <= 10; ++key) {
+        LRUPut(cache2, key, (void*) key, 150);
+    }
+    assert(cache2->len == 6 && cache2->bytes == 900);
+    void *gone = LRUGet(cache2, 4);
+    void *kept = LRUGet(cache2, 5);
+    assert(gone == NULL && kept == (void*) 5);
+    LRUPut(cache2, StrL("big"), (void*) 1, 1000);
+    void *big = LRUGet(cache2, StrL("big"));
+    assert(cache2->len == 1 && big == (void*) 1);
+    bool removed = LRURemove(cache2, StrL("big"));
+    assert(removed && cache2->len == 0 && cache2->bytes == 0);
+
+    printf("recency order, eviction, byte budget OK\n");
+    ArenaDestroy(a);
+}
+
+
+void TestRandStreams() {
+    printf("\nTestRandStreams\n");
+
+    // xoshiro256++ reference output for the state { 1, 2, 3, 4 }
+    RandState ref = { { 1, 2, 3, 4 } };
+    u64 ref_draw = RandNext(&ref);
+    assert(ref_draw == 41943041);
+
+    // streams are reproducible, differ from each other and do not depend on how many are made
+    RandState streams[8];
+    RandStreams(1234, streams, 8);
+    for (u32 i = 0; i < 8; ++i) {
+        RandState again = RandStream(1234, i);
+        assert(memcmp(&again, streams + i, sizeof(RandState)) == 0);
+        for (u32 j = 0; j < i; ++j) {
+            assert(memcmp(streams + j, streams + i, sizeof(RandState)) != 0);
+        }
+    }
+    RandState split = InitRandState(1234);
+    RandState first = RandSplit(&split);
+    u64 split_draws[4] = { RandNext(&first), RandNext(streams), RandNext(&split), RandNext(streams + 1) };
+    assert(split_draws[0] == split_draws[1] && split_draws[2] == split_draws[3]);
+
+    // workers on their own streams get the same results whatever order they run in
+    u64 sums[2][4] = {};
+    for (u32 run = 0; run < 2; ++run) {
+        RandStreams(99, streams, 4);
+        std::thread workers[4];
+        for (u32 t = 0; t < 4; ++t) {
+            u32 w = run ? 3 - t : t;
+            workers[t] = std::thread([&sums, &streams, run, w]() {
+                for (u32 i = 0; i < 100000; ++i) {
+                    sums[run][w] += RandMinMaxU(streams + w, 0, 1000);
+                }
+            });
+        }
+        for (u32 t = 0; t < 4; ++t) {
+            workers[t].join();
+        }
+    }
+    assert(memcmp(sums[0], sums[1], sizeof(sums[0])) == 0);
+
+    // default states are per thread
+    RandInit(7);
+    u64 main_draw = RandNext(&g_randstate);
+    u64 thread_draw = 0;
+    std::thread other([&thread_draw]() { thread_draw = RandMinMax64(1, UINT64_MAX - 1); });
+    other.join();
+    RandInit(7);
+    u64 again_draw = RandNext(&g_randstate);
+    assert(again_draw == main_draw && thread_draw != main_draw);
+
+    printf("reference output, streams, split, per-thread defaults OK\n");
+}
+
+
+void TestRandBatch() {
+    printf("\nTestRandBatch\n");
+
+    MArena _a = ArenaCreate();
+    MArena *a = &_a;
+
+    // lane l of every block continues stream l, on AVX2 and scalar builds alike
+    RandState r = InitRandState(5);
+    RandState streams[RAND_LANES];
+    RandStreams(5, streams, RAND_LANES);
+    RandBatch rb = InitRandBatch(&r);
+    u32 cnt = 1003;
+    u64 *raw = (u64*) ArenaAlloc(a, sizeof(u64) * cnt);
+    RandFillU64(&rb, raw, cnt);
+    for (u32 i = 0; i < cnt; ++i) {
+        u64 draw = RandNext(streams + i % RAND_LANES);
+        assert(raw[i] == draw);
+    }
+
+    // floats stay in [0, 1) and average out near 0.5
+    f32 *fs = (f32*) ArenaAlloc(a, sizeof(f32) * 100001);
+    f64 *ds = (f64*) ArenaAlloc(a, sizeof(f64) * 100001);
+    RandFillF32(&rb, fs, 100001);
+    RandFillF64(&rb, ds, 100001);
+    f64 fsum = 0;
+    f64 dsum = 0;
+    for (u32 i = 0; i < 100001; ++i) {
+        assert(fs[i] >= 0 && fs[i] < 1 && ds[i] >= 0 && ds[i] < 1);
+        fsum += fs[i];
+        dsum += ds[i];
+    }
+    assert(fsum / 100001 > 0.49 && fsum / 100001 < 0.51);
+    assert(dsum / 100001 > 0.49 && dsum / 100001 < 0.51);
+
+    // bounded integers hit every value of a small range, and the full u32 range works
+    u32 *us = (u32*) ArenaAlloc(a, sizeof(u32) * 100001);
+    RandFillRange(&rb, us, 100001, 10, 19);
+    u32 hits[10] = {};
+    for (u32 i = 0; i < 100001; ++i) {
+        assert(us[i] >= 10 && us[i] <= 19);
+        hits[us[i] - 10]++;
+    }
+    for (u32 i = 0; i < 10; ++i) {
+        assert(hits[i] > 9000 && hits[i] < 11000);
+    }
+    RandFillRange(&rb, us, 7, 0, 0xFFFFFFFF);
+
+    printf("lanes match scalar streams, floats, ranges OK\n");
+    ArenaDestroy(a);
+}
+
+
+void TestPhilox() {
+    printf("\nTestPhilox\n");
+
+    // known-answer vectors of the Random123 reference implementation
+    u32 ctrs[3][4] = { { 0, 0, 0, 0 }, { 0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff }, { 0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344 } };
+    u32 keys[3][2] = { { 0, 0 }, { 0xffffffff, 0xffffffff }, { 0xa4093822, 0x299f31d0 } };
+    u32 expect[3][4] = { { 0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8 }, { 0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd }, { 0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1 } };
+    for (u32 i = 0; i < 3; ++i) {
+        u32 out[4];
+        PhiloxBlock(ctrs[i], keys[i], out);
+        assert(memcmp(out, expect[i], sizeof(out)) == 0);
+    }
+
+    // fills match single draws, across the SIMD and scalar parts and a block counter carry
+    u32 cnt = 1000 * 4 + 3;
+    u32 *fill = (u32*) malloc(sizeof(u32) * cnt);
+    Philox p = InitPhilox(77, 5, 0xFFFFFFFF - 40);
+    PhiloxFillU32(&p, fill, cnt);
+    Philox q = InitPhilox(77, 5, 0xFFFFFFFF - 40);
+    for (u32 i = 0; i < cnt; ++i) {
+        u32 draw = PhiloxNext32(&q);
+        assert(fill[i] == draw);
+    }
+    free(fill);
+
+    // per-element generators are independent of the order they are used in
+    f64 fwd[64];
+    for (u32 i = 0; i < 64; ++i) {
+        Philox e = InitPhilox(3, i);
+        fwd[i] = Rand01(&e);
+    }
+    for (s32 i = 63; i >= 0; --i) {
+        Philox e = InitPhilox(3, i);
+        f64 bwd = Rand01(&e);
+        assert(bwd == fwd[i] && fwd[i] >= 0 && fwd[i] < 1);
+        u32 r = RandMinMaxU(&e, 10, 20);
+        f32 pm = RandPM1_f32(&e);
+        assert(r >= 10 && r <= 20 && pm >= -1 && pm <= 1);
+    }
+    f32 fs[37];
+    Philox f = InitPhilox(3);
+    PhiloxFillF32(&f, fs, 37);
+    for (u32 i = 0; i < 37; ++i) {
+        assert(fs[i] >= 0 && fs[i] < 1);
+    }
+
+    printf("known answers, fills, per-element streams OK\n");
+}
+
+
+void TestDistributions() {
+    printf("\nTestDistributions\n");
+
+    MArena _a = ArenaCreate();
+    MArena *a = &_a;
+    RandState r = InitRandState(RandInit());
+
+    // normal: moments, the share within one sigma and the tails beyond the ziggurat's base strip
+    u32 cnt = 1000000;
+    f64 *xs = (f64*) ArenaAlloc(a, sizeof(f64) * cnt);
+    RandFillNormal(&r, xs, cnt);
+    f64 sum = 0;
+    f64 sumsq = 0;
+    u32 within = 0;
+    u32 tails = 0;
+    for (u32 i = 0; i < cnt; ++i) {
+        sum += xs[i];
+        sumsq += xs[i] * xs[i];
+        within += fabs(xs[i]) < 1;
+        tails += fabs(xs[i]) > ZIG_NOR_R;
+    }
+    f64 mean = sum / cnt;
+    assert(fabs(mean) < 0.005 && fabs(sumsq / cnt - mean * mean - 1) < 0.01);
+    assert(fabs((f64) within / cnt - 0.682689) < 0.003);
+    assert(tails > 400 && tails < 750); // expected 576
+    assert(fabs(RandNormal(&r, 100, 0.001) - 100) < 1);
+
+    // exponential: mean and variance 1 / rate
+    RandFillExp(&r, xs, cnt, 2);
+    sum = 0;
+    sumsq = 0;
+    for (u32 i = 0; i < cnt; ++i) {
+        assert(xs[i] >= 0);
+        sum += xs[i];
+        sumsq += xs[i] * xs[i];
+    }
+    mean = sum / cnt;
+    assert(fabs(mean - 0.5) < 0.005 && fabs(sumsq / cnt - mean * mean - 0.25) < 0.01);
+
+    // alias table follows the weights, zero weights are never drawn
+    f64 weights[] = { 1, 0, 3, 6, 0.5, 0, 9.5 };
+    AliasTable tbl = InitAliasTable(a, weights, 7);
+    u32 *idxs = (u32*) ArenaAlloc(a, sizeof(u32) * cnt);
+    AliasSampleBatch(&tbl, &r, idxs, cnt);
+    u32 hits[7] = {};
+    for (u32 i = 0; i < cnt; ++i) {
+        hits[idxs[i]]++;
+    }
+    for (u32 i = 0; i < 7; ++i) {
+        assert(fabs((f64) hits[i] / cnt - weights[i] / 20) < 0.003);
+    }
+    assert(hits[1] == 0 && hits[5] == 0);
+
+    // shuffle: a permutation, and each value lands in each position equally often
+    u32 counts[5][5] = {};
+    List<u32> lst = InitList<u32>(a, 5);
+    for (u32 round = 0; round < 50000; ++round) {
+        lst.len = 0;
+        for (u32 i = 0; i < 5; ++i) {
+            lst.Add(i);
+        }
+        Shuffle(&r, lst);
+        for (u32 i = 0; i < 5; ++i) {
+            counts[lst.lst[i]][i]++;
+        }
+    }
+    for (u32 v = 0; v < 5; ++v) {
+        for (u32 i = 0; i < 5; ++i) {
+            assert(counts[v][i] > 9400 && counts[v][i] < 10600);
+        }
+    }
+
+    // reservoir: every stream item is kept with probability k / n, whether offered one by one or in batches
+    u32 n = 1000;
+    u32 k = 10;
+    u32 *items = (u32*) ArenaAlloc(a, sizeof(u32) * n);
+    u32 *kept = (u32*) ArenaAlloc(a, sizeof(u32) * n);
+    for (u32 i = 0; i < n; ++i) {
+        items[i] = i;
+    }
+    u32 rounds = 4000;
+    for (u32 round = 0; round < rounds; ++round) {
+        Reservoir<u32> res = InitReservoir<u32>(a, k);
+        if (round % 2) {
+            for (u32 i = 0; i < n; ++i) {
+                ReservoirAdd(&res, &r, items[i]);
+            }
+        }
+        else {
+            ReservoirAddBatch(&res, &r, items, 7);
+            ReservoirAddBatch(&res, &r, items + 7, n - 7);
+        }
+        assert(res.len == k && res.seen == n);
+        for (u32 i = 0; i < k; ++i) {
+            kept[res.lst[i]]++;
+        }
+    }
+    u32 first_half = 0;
+    for (u32 i = 0; i < n; ++i) {
+        first_half += (i < n / 2) ? kept[i] : 0;
+    }
+    assert(fabs((f64) first_half / (rounds * k) - 0.5) < 0.02);
+    assert(kept[0] > 10 && kept[n - 1] > 10); // expected 40 each
+
+    printf("normal, exponential, alias, shuffle, reservoir OK\n");
+    ArenaDestroy(a);
+}
+
+
 void TestHashString() {
     printf("TestHashStrings\n\n");
 
@@ -296,6 +1507,76 @@ void TestHashString() {
     printf("%lu\n\n", val);
 }
 
+int _CompareU64(const void *a, const void *b) {
+    u64 x = *(u64*) a;
+    u64 y = *(u64*) b;
+    return (x > y) - (x < y);
+}
+
+void TestHashBytes() {
+    printf("\nTestHashBytes\n");
+
+    MArena _a = ArenaCreate();
+    MArena *a = &_a;
+    RandInit();
+
+    // every length through all code paths, at every alignment: stable, seed-dependent and distinct
+    u8 buff[300];
+    for (u32 i = 0; i < 300; ++i) {
+        buff[i] = (i < 8) ? (u8) i : (u8) RandIntMax(256); // distinct first bytes keep the spans distinct
+    }
+    u32 nhashes = 0;
+    u64 *hashes = (u64*) ArenaAlloc(a, sizeof(u64) * 3 * 256 * 8);
+    for (u32 len = 0; len < 256; ++len) {
+        for (u32 off = 0; off < 8; ++off) {
+            u8 copy[300];
+            memcpy(copy + 8 - off, buff + off, len);
+            u64 h = HashBytes(buff + off, len);
+            assert(h == HashBytes(copy + 8 - off, len));
+            assert(h != HashBytes(buff + off, len, 1));
+            assert(HashBytesAES(buff + off, len) == HashBytesAES(copy + 8 - off, len));
+            hashes[nhashes++] = h;
+            hashes[nhashes++] = HashBytes(buff + off, len, 1);
+            hashes[nhashes++] = HashBytesAES(buff + off, len, 7);
+        }
+    }
+    // len 0 hashes alike for every offset
+    qsort(hashes, nhashes, sizeof(u64), _CompareU64);
+    u32 ndups = 0;
+    for (u32 i = 1; i < nhashes; ++i) {
+        ndups += (hashes[i] == hashes[i - 1]);
+    }
+    assert(ndups == 3 * 7);
+
+    // single bit flips change about half of the output bits, for the byte hashes and the integer mixer
+    u32 flips[3] = {};
+    u32 trials = 0;
+    for (u32 t = 0; t < 64; ++t) {
+        u32 len = 1 + RandIntMax(128);
+        u64 x = RandMinMax64(1, UINT64_MAX - 1);
+        u64 hb = HashBytes(buff, len);
+        u64 ha = HashBytesAES(buff, len);
+        u64 hx = Hash64(x);
+        for (u32 bit = 0; bit < 8 * MinU32(len, 8); ++bit) {
+            buff[bit / 8] ^= (u8) (1 << (bit % 8));
+            flips[0] += PopcntU32((u32) (hb ^ HashBytes(buff, len))) + PopcntU32((u32) ((hb ^ HashBytes(buff, len)) >> 32));
+            flips[1] += PopcntU32((u32) (ha ^ HashBytesAES(buff, len))) + PopcntU32((u32) ((ha ^ HashBytesAES(buff, len)) >> 32));
+            buff[bit / 8] ^= (u8) (1 << (bit % 8));
+            u64 dx = hx ^ Hash64(x ^ (1ull << (bit % 64)));
+            flips[2] += PopcntU32((u32) dx) + PopcntU32((u32) (dx >> 32));
+            trials++;
+        }
+    }
+    for (u32 i = 0; i < 3; ++i) {
+        f32 avg = (f32) flips[i] / trials;
+        assert(avg > 30 && avg < 34);
+    }
+
+    printf("lengths, alignment, seeds and avalanche OK (%s)\n", SIMD_AES ? "aes" : "no aes");
+    ArenaDestroy(a);
+}
+
+
 void TestHashMap() {
     printf("TestHashMap\n");
     MContext *ctx = GetContext(1024 * 1024);
@@ -361,15 +1642,529 @@ void TestHashMap() {
     }
 }
 
+void TestHashMapGrow() {
+    printf("\nTestHashMapGrow\n");
+
+    MArena _a = ArenaCreate();
+    MArena *a = &_a;
+    RandInit();
+
+    // starts tiny, grows through many incremental rehashes while keys are overwritten and removed
+    HashMap map = InitMap(a, 8, true);
+    u32 nkeys = 50000;
+    u64 *keys = (u64*) ArenaAlloc(a, sizeof(u64) * nkeys);
+    u64 *vals = (u64*) ArenaAlloc(a, sizeof(u64) * nkeys);
+    u32 nlive = 0;
+    for (u32 i = 0; i < nkeys; ++i) {
+        keys[i] = (RandIntMax(2) == 1) ? (u64) (i + 1) * 16 : RandMinMax64(1, UINT64_MAX - 1); // aligned and random
+        vals[i] = i + 1;
+        MapPut(&map, keys[i], vals[i]);
+        nlive++;
+
+        u32 r = RandIntMax(i + 1) - 1;
+        if (RandIntMax(8) == 1 && vals[r]) {
+            s64 removed = MapRemove(&map, keys[r]);
+            assert(removed != -1);
+            vals[r] = 0;
+            nlive--;
+        }
+        else if (RandIntMax(8) == 1 && vals[r]) {
+            vals[r] += nkeys;
+            MapPut(&map, keys[r], vals[r]);
+        }
+        assert(map.load == nlive);
+        assert(map.load <= map.max_load * map.slots.len);
+
+        if (i % 997 == 0) {
+            for (u32 j = 0; j <= i; ++j) {
+                assert(MapGet(&map, keys[j]) == vals[j]);
+            }
+        }
+    }
+    for (u32 j = 0; j < nkeys; ++j) {
+        assert(MapGet(&map, keys[j]) == vals[j]);
+    }
+    map.Print();
+    assert(map.slots.len == 65536 || map.slots.len == 131072);
+
+    // batches agree with single lookups, also for misses, key 0 and keys put in the middle of a rehash
+    u64 *got = (u64*) ArenaAlloc(a, sizeof(u64) * nkeys);
+    keys[7] = 0;
+    MapGetBatch(&map, keys, got, nkeys);
+    for (u32 j = 0; j < nkeys; ++j) {
+        assert(got[j] == MapGet(&map, keys[j]));
+    }
+    keys[7] = 1;
+    HashMap single = InitMap(a, 8, true);
+    HashMap batched = InitMap(a, 8, true);
+    for (u32 j = 0; j < nkeys; ++j) {
+        MapPut(&single, keys[j], j + 1);
+        vals[j] = j + 1;
+    }
+    u32 stored = MapPutBatch(&batched, keys, vals, nkeys);
+    assert(stored == nkeys && batched.load == single.load);
+    MapGetBatch(&batched, keys, got, nkeys);
+    for (u32 j = 0; j < nkeys; ++j) {
+        assert(got[j] == MapGet(&single, keys[j]));
+    }
+    MapRehashFinish(&single);
+    assert(single.old.len == 0);
+    for (u32 j = 0; j < nkeys; ++j) {
+        assert(MapGet(&single, keys[j]) == j + 1);
+    }
+
+    // fixed-size maps keep overflowing instead
+    HashMap fixed = InitMap(a, 12, false);
+    assert(fixed.slots.len == 16);
+    for (u32 i = 0; i < 16; ++i) {
+        s64 put = MapPut(&fixed, i + 1, i + 1);
+        assert(put >= 0);
+    }
+    s64 overflow = MapPut(&fixed, 17, 17);
+    assert(overflow == -1 && fixed.overflows == 1);
+
+    printf("growth, incremental rehash, batches and fixed-size overflow OK\n");
+    ArenaDestroy(a);
+}
+
+
+void TestDenseMap() {
+    printf("\nTestDenseMap\n");
+
+    MArena _a = ArenaCreate();
+    MArena *a = &_a;
+    RandInit();
+
+    // random puts, overwrites and removes against a reference of live keys in insertion order
+    u32 nkeys = 20000;
+    u64 *keys = (u64*) ArenaAlloc(a, sizeof(u64) * nkeys);
+    u64 *vals = (u64*) ArenaAlloc(a, sizeof(u64) * nkeys);
+    DenseMap map = InitDenseMap(a);
+    for (u32 round = 0; round < 2; ++round) {
+        for (u32 i = 0; i < nkeys; ++i) {
+            keys[i] = (RandIntMax(2) == 1) ? (u64) (i + 1) * 8 : RandMinMax64(1, UINT64_MAX - 1) | 1;
+            vals[i] = i + 1;
+            s64 put = MapPut(&map, keys[i], vals[i]);
+            assert(put >= 0);
+
+            u32 r = RandIntMax(i + 1) - 1;
+            if (RandIntMax(4) == 1 && vals[r]) {
+                s64 removed = MapRemove(&map, keys[r]);
+                assert(removed != -1);
+                vals[r] = 0;
+            }
+            else if (RandIntMax(4) == 1 && vals[r]) {
+                vals[r] += nkeys;
+                MapPut(&map, keys[r], vals[r]);
+            }
+        }
+
+        MapIter iter = {};
+        u32 i = 0;
+        while (DenseEntry *e = MapNext(&map, &iter)) {
+            while (vals[i] == 0) {
+                i++;
+            }
+            assert(e->key == keys[i] && e->val == vals[i]);
+            i++;
+        }
+        assert((u32) iter.occ_slots_cnt == map.len);
+        for (u32 j = 0; j < nkeys; ++j) {
+            assert(MapGet(&map, keys[j]) == vals[j]);
+        }
+
+        // O(1) clear, the next round re-uses the tables
+        MapClear(&map);
+        s64 missing = MapRemove(&map, keys[nkeys - 1]);
+        assert(map.len == 0 && MapGet(&map, keys[nkeys - 1]) == 0 && missing == -1);
+        MapIter empty = {};
+        DenseEntry *none = MapNext(&map, &empty);
+        assert(none == NULL);
+    }
+
+    // MapIter also walks a HashMap's live slots, across both tables during a rehash
+    HashMap hmap = InitMap(a, 8, true);
+    for (u32 i = 0; i < 770; ++i) {
+        MapPut(&hmap, i + 1, i + 1); // the 769th put starts a rehash from 1024 to 2048 slots
+    }
+    assert(hmap.old.len > 0);
+    u64 sum = 0;
+    MapIter iter = {};
+    while (KeyVal *kv = MapNext(&hmap, &iter)) {
+        sum += kv->val;
+    }
+    assert(sum == 770 * 771 / 2);
+
+    printf("insertion order, removes, O(1) clear, iteration OK\n");
+    ArenaDestroy(a);
+}
+
+
+void TestSwissMap() {
+    printf("\nTestSwissMap\n");
+
+    MArena _a = ArenaCreate();
+    MArena *a = &_a;
+    RandInit();
+
+    // grows from the minimum size under puts, overwrites and removes, key 0 included
+    SwissMap map = InitSwissMap(a, 0);
+    u32 nkeys = 50000;
+    u64 *keys = (u64*) ArenaAlloc(a, sizeof(u64) * nkeys);
+    u64 *vals = (u64*) ArenaAlloc(a, sizeof(u64) * nkeys);
+    bool *live = (bool*) ArenaAlloc(a, sizeof(bool) * nkeys);
+    u32 nlive = 0;
+    for (u32 i = 0; i < nkeys; ++i) {
+        keys[i] = (RandIntMax(2) == 1) ? (u64) i * 16 : RandMinMax64(1, UINT64_MAX - 1);
+        vals[i] = RandMinMax64(1, UINT64_MAX - 1);
+        s64 put = MapPut(&map, keys[i], vals[i]);
+        assert(put >= 0);
+        live[i] = true;
+        nlive++;
+
+        u32 r = RandIntMax(i + 1) - 1;
+        if (RandIntMax(4) == 1 && live[r]) {
+            s64 removed = MapRemove(&map, keys[r]);
+            s64 again = MapRemove(&map, keys[r]);
+            assert(removed >= 0 && again == -1);
+            live[r] = false;
+            nlive--;
+        }
+        else if (RandIntMax(8) == 1 && live[r]) {
+            vals[r]++;
+            MapPut(&map, keys[r], vals[r]);
+        }
+        assert(map.len == nlive);
+    }
+    for (u32 i = 0; i < nkeys; ++i) {
+        assert(MapContains(&map, keys[i]) == live[i]);
+        if (live[i]) {
+            assert(MapGet(&map, keys[i]) == vals[i]);
+        }
+    }
+    map.Print();
+
+    // fixed size: fills to max_load under tombstone churn, then refuses
+    SwissMap fixed = InitSwissMap(a, 256, false);
+    u32 limit = (u32) (fixed.max_load * fixed.Cap());
+    for (u32 round = 0; round < 20; ++round) {
+        for (u32 i = 0; i < limit; ++i) {
+            s64 put = MapPut(&fixed, round * 1000 + i, i);
+            assert(put >= 0);
+        }
+        s64 overflow = MapPut(&fixed, 999999, (u64) 0);
+        assert(overflow == -1);
+        for (u32 i = 0; i < limit; ++i) {
+            s64 removed = MapRemove(&fixed, round * 1000 + i);
+            assert(removed >= 0);
+        }
+    }
+    assert(fixed.len == 0 && fixed.Cap() == 256);
+
+    printf("put/get/remove, growth, tombstones and fixed-size OK\n");
+    ArenaDestroy(a);
+}
+
+
+struct TestParticle {
+    f32 pos[3];
+    u32 id;
+};
+
+struct TestCellKey {
+    s16 x;
+    s16 y;
+    s32 z;
+};
+
+struct TestCellHasher {
+    static u64 Hash(TestCellKey key) {
+        return ((u64) (u16) key.x << 48) ^ ((u64) (u16) key.y << 32) ^ (u32) key.z;
+    }
+    static bool Equal(TestCellKey a, TestCellKey b) {
+        return a.x == b.x && a.y == b.y && a.z == b.z;
+    }
+};
+
+void TestHashMapT() {
+    printf("\nTestHashMapT\n");
+
+    MArena _a = ArenaCreate();
+    MArena *a = &_a;
+    RandInit();
+
+    // compact u32 -> u32 against a reference, with growth and backward-shift removes
+    HashMapT<u32, u32> small = InitHashMapT<u32, u32>(a, 8);
+    assert(sizeof(HashMapT<u32, u32>::Slot) == 8);
+    u32 nkeys = 4096;
+    u32 *ref = (u32*) ArenaAlloc(a, sizeof(u32) * (nkeys + 1));
+    u32 nlive = 0;
+    for (u32 iter = 0; iter < 100000; ++iter) {
+        u32 key = RandIntMax(nkeys);
+        if (RandIntMax(3) == 1) {
+            bool removed = small.Remove(key);
+            assert(removed == (ref[key] != 0));
+            nlive -= (ref[key] != 0);
+            ref[key] = 0;
+        }
+        else {
+            u32 val = RandIntMax(1000000);
+            u32 *put = small.Put(key, val);
+            assert(*put == val);
+            nlive += (ref[key] == 0);
+            ref[key] = val;
+        }
+        assert(small.len == nlive);
+    }
+    for (u32 key = 1; key <= nkeys; ++key) {
+        u32 *val = small.Get(key);
+        assert((val ? *val : 0) == ref[key]);
+    }
+
+    // struct values are written and read in place
+    HashMapT<u64, TestParticle> particles = InitHashMapT<u64, TestParticle>(a, 64);
+    for (u32 i = 1; i <= 1000; ++i) {
+        TestParticle p = { { (f32) i, 0, 0 }, i };
+        particles.Put((u64) i << 32, p);
+    }
+    particles.Get(500ull << 32)->pos[1] = 7.0f;
+    assert(particles.Get(500ull << 32)->pos[1] == 7.0f && particles.Get(500ull << 32)->id == 500);
+    assert(particles.Get(1001ull << 32) == NULL);
+
+    // struct keys with a custom hasher, fixed size refuses once full
+    HashMapT<TestCellKey, u32, TestCellHasher> cells = InitHashMapT<TestCellKey, u32, TestCellHasher>(a, 64, false);
+    u32 limit = (u32) (cells.max_load * cells.Cap());
+    for (u32 i = 0; i < limit; ++i) {
+        u32 *put = cells.Put(TestCellKey { (s16) i, (s16) -i, (s32) i + 1 }, i);
+        assert(put != NULL);
+    }
+    u32 *overflow = cells.Put(TestCellKey { 1000, 0, 0 }, 0);
+    assert(overflow == NULL);
+    assert(*cells.Get(TestCellKey { 3, -3, 4 }) == 3);
+    assert(cells.Get(TestCellKey { 3, 3, 4 }) == NULL);
+
+    printf("compact slots, struct values, custom hasher OK\n");
+    ArenaDestroy(a);
+}
+
+
+void TestStrMap() {
+    printf("\nTestStrMap\n");
+
+    MArena _a = ArenaCreate();
+    MArena *a = &_a;
+    MArena _a_keys = ArenaCreate();
+    MArena *a_keys = &_a_keys;
+    RandInit();
+
+    // "AB" and "B!" have the same djb2 hash, the old Str wrappers of MapPut would overwrite one with the other
+    StrMap map = InitStrMap(a, a_keys, 8);
+    StrMapPut(&map, "AB", 1);
+    StrMapPut(&map, "B!", 2);
+    assert(StrMapGet(&map, "AB") == 1 && StrMapGet(&map, "B!") == 2);
+    assert(StrMapGet(&map, "") == 0);
+    StrMapPut(&map, "", 3);
+    assert(StrMapGet(&map, "") == 3 && map.len == 3);
+
+    // random identifiers against their index
+    u32 nkeys = 100000;
+    Str *keys = (Str*) ArenaAlloc(a, sizeof(Str) * nkeys);
+    for (u32 i = 0; i < nkeys; ++i) {
+        char buff[32];
+        u32 len = sprintf(buff, "id_%x_%u", RandIntMax(1 << 30), i);
+        keys[i] = StrPush(a, Str { buff, len });
+        StrMapPut(&map, keys[i], i + 1);
+    }
+    for (u32 i = 0; i < nkeys; i += 2) {
+        bool removed = StrMapRemove(&map, keys[i]);
+        assert(removed);
+    }
+    for (u32 i = 0; i < nkeys; ++i) {
+        assert(StrMapGet(&map, keys[i]) == ((i % 2) ? i + 1 : 0));
+        if (i % 2) {
+            s64 idx = StrMapFind(&map, keys[i]);
+            assert(StrEqual(map.Key(idx), keys[i]));
+        }
+    }
+    assert(map.len == 3 + nkeys / 2);
+
+    // bulk load: one blob allocation, duplicates overwrite and take no blob space
+    StrMap bulk = InitStrMap(a, a_keys);
+    u64 used = a_keys->used;
+    u32 nbulk = 1000;
+    u64 nbytes = 0;
+    for (u32 i = 0; i < nbulk; ++i) {
+        keys[i + nbulk] = keys[i]; // every key twice
+        nbytes += keys[i].len;
+    }
+    StrMapBulkLoad(&bulk, keys, NULL, 2 * nbulk);
+    assert(bulk.len == nbulk && a_keys->used - used == nbytes);
+    for (u32 i = 0; i < nbulk; ++i) {
+        assert(StrMapGet(&bulk, keys[i]) == i + nbulk + 1);
+    }
+
+    StrLst *lst = NULL;
+    lst = StrLstPush("src/base.h", lst);
+    lst = StrLstPush("src/hash.h", lst);
+    StrMap files = InitStrMap(a, a_keys);
+    StrMapBulkLoad(&files, lst->first);
+    assert(StrMapGet(&files, "src/hash.h") == 2 && files.len == 2);
+
+    printf("collisions, put/get/remove, bulk loading OK\n");
+    ArenaDestroy(a_keys);
+    ArenaDestroy(a);
+}
+
+
+void TestStrInterns() {
+    printf("\nTestStrInterns\n");
+
+    MArena _a = ArenaCreate();
+    MArena *a = &_a;
+    MArena _a_keys = ArenaCreate();
+    MArena *a_keys = &_a_keys;
+    RandInit();
+
+    StrInterns syms = InitStrInterns(a, a_keys, 8);
+    assert(StrInternLookup(&syms, StrL("x")) == STR_INTERN_NONE);
+    u32 x = StrInternId(&syms, "x");
+    u32 empty = StrInternId(&syms, "");
+    assert(x == 0 && empty == 1 && StrInternLookup(&syms, StrL("x")) == x);
+    assert(StrInternGet(&syms, empty).len == 0);
+
+    // repeated identifiers map to the same id and take no more blob space
+    u32 ndistinct = 5000;
+    Str *strs = (Str*) ArenaAlloc(a, sizeof(Str) * ndistinct);
+    for (u32 i = 0; i < ndistinct; ++i) {
+        char buff[32];
+        u32 len = sprintf(buff, "sym_%u_%x", i, RandIntMax(1 << 20));
+        strs[i] = StrPush(a, Str { buff, len });
+        u32 id = StrInternId(&syms, strs[i]);
+        assert(id == i + 2);
+    }
+    u64 used = a_keys->used;
+    for (u32 r = 0; r < 50000; ++r) {
+        u32 i = RandIntMax(ndistinct) - 1;
+        Str copy = StrPush(a, strs[i]);
+        u32 id = StrInternId(&syms, copy);
+        assert(id == i + 2);
+    }
+    assert(a_keys->used == used && syms.Len() == ndistinct + 2);
+
+    // reverse lookup returns the one stored copy
+    for (u32 i = 0; i < ndistinct; ++i) {
+        Str s = StrInternGet(&syms, i + 2);
+        assert(StrEqual(s, strs[i]) && s.str != strs[i].str);
+        Str interned = StrIntern(&syms, strs[i]);
+        assert(interned.str == s.str);
+    }
+
+    printf("ids, dedup, reverse lookup OK\n");
+    ArenaDestroy(a_keys);
+    ArenaDestroy(a);
+}
+
+
+void TestPerfectHash() {
+    printf("\nTestPerfectHash\n");
+
+    MArena _a = ArenaCreate();
+    MArena *a = &_a;
+    RandInit();
+
+    // every key gets its own index in [0, n)
+    u32 sizes[] = { 1, 2, 3, 100, 200000 };
+    for (u32 s = 0; s < 5; ++s) {
+        u32 n = sizes[s];
+        List<u64> keys = InitList<u64>(a, n);
+        for (u32 i = 0; i < n; ++i) {
+            keys.Add((RandIntMax(2) == 1) ? (u64) i * 64 : RandMinMax64(1, UINT64_MAX - 1) | 1); // aligned and random
+        }
+        PerfectHash ph = PerfectHashBuild(a, keys);
+        u8 *seen = (u8*) ArenaAlloc(a, n);
+        for (u32 i = 0; i < n; ++i) {
+            u32 idx = PerfectHashIdx(&ph, keys.lst[i]);
+            assert(idx < n && seen[idx] == 0);
+            seen[idx] = 1;
+        }
+    }
+
+    // string keys, and a serialized copy agrees with the original
+    const char *idents[] = {
+        "PSDbefore_guides_blitarea", "l_mon_source_blitarea", "PSDbefore_curve_blitarea", "PSDafter_curve_blitarea",
+        "ydist_fluxpos_blitarea", "PSD_fluxpos_blitarea", "xdist_flux_pos_blitarea", "PSD_fluxposB_blitarea",
+        "lambda_in_blitarea", "PSD_sample_blitarea", "lambda_sample_blitarea", "Detector_blitarea"
+    };
+    u32 n = 12;
+    Str *strs = (Str*) ArenaAlloc(a, sizeof(Str) * n);
+    for (u32 i = 0; i < n; ++i) {
+        strs[i] = StrL(idents[i]);
+    }
+    PerfectHash ph = PerfectHashBuild(a, strs, n);
+    u64 size;
+    u8 *blob = PerfectHashSerialize(a, &ph, &size);
+    PerfectHash loaded = PerfectHashLoad(blob, size);
+    u32 seen = 0;
+    for (u32 i = 0; i < n; ++i) {
+        u32 idx = PerfectHashIdx(&ph, strs[i]);
+        assert(idx < n && (seen & (1 << idx)) == 0);
+        assert(PerfectHashIdx(&loaded, strs[i]) == idx);
+        seen |= 1 << idx;
+    }
+    assert(PerfectHashLoad(blob, size - 4).pilots == NULL);
+    assert(PerfectHashLoad(blob + 4, size - 4).pilots == NULL);
+    blob[0] ^= 1;
+    assert(PerfectHashLoad(blob, size).pilots == NULL);
+
+    // duplicate keys give an empty PerfectHash
+    List<u64> dups = InitList<u64>(a, 3);
+    dups.Add(7);
+    dups.Add(9);
+    dups.Add(7);
+    PerfectHash dup_ph = PerfectHashBuild(a, dups);
+    assert(dup_ph.pilots == NULL);
+    strs[n - 1] = strs[0];
+    dup_ph = PerfectHashBuild(a, strs, n);
+    assert(dup_ph.pilots == NULL);
+
+    printf("u64 and string keys, serialization OK\n");
+    ArenaDestroy(a);
+}
+
+
 void Test() {
     printf("Running baselayer tests ...\n\n");
 
     TestStringBasics();
     TestSorting();
+    TestSetAlgebra();
+    TestPackedU32();
+    TestHeap();
+    TestQueueSPSC();
+    TestQueueMPMC();
+    TestConcurrentMap();
+    TestBucketArray();
+    TestSlotMap();
+    TestART();
+    TestFlatTree();
     TestStringHelpers();
     TestMemoryPool();
     TestPoolAllocatorAgain();
     TestStrBuffer();
+    TestRandStreams();
+    TestRandBatch();
+    TestPhilox();
+    TestDistributions();
     TestHashString();
+    TestHashBytes();
     TestHashMap();
+    TestHashMapGrow();
+    TestDenseMap();
+    TestSwissMap();
+    TestHashMapT();
+    TestStrMap();
+    TestStrInterns();
+    TestPerfectHash();
+    TestLRUCache();
+    TestFilters();
 }